@@ -1203,23 +1203,16 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
                                   &message_state->params.iface);
     if (hr == S_OK)
     {
-        /* stub, chan, iface and iid are unneeded in multi-threaded case as we go
-         * via the RPC runtime */
-        if (apt->multi_threaded)
+        /* the object lives in this process, so the call can be handed over
+         * directly instead of going through the RPC runtime. Calls into the
+         * multi-threaded apartment are run on a worker thread, calls into a
+         * single-threaded apartment are posted to its window. */
+        message_state->params.bypass_rpcrt = TRUE;
+        if (!apt->multi_threaded)
         {
-            IRpcStubBuffer_Release(message_state->params.stub);
-            message_state->params.stub = NULL;
-            IRpcChannelBuffer_Release(message_state->params.chan);
-            message_state->params.chan = NULL;
-            message_state->params.iface = NULL;
-        }
-        else
-        {
-            message_state->params.bypass_rpcrt = TRUE;
             message_state->target_hwnd = apartment_getwindow(apt);
             message_state->target_tid = apt->tid;
-            /* we assume later on that this being non-NULL is the indicator that
-             * means call directly instead of going through RPC runtime */
+            /* ClientRpcChannelBuffer_SendReceive posts the call to this window */
             if (!message_state->target_hwnd)
                 ERR("window for apartment %s is NULL\n", wine_dbgstr_longlong(apt->oxid));
         }
@@ -1230,7 +1223,7 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
      * ClientRpcChannelBuffer_SendReceive */
 
     /* shortcut the RPC runtime */
-    if (message_state->target_hwnd)
+    if (message_state->params.bypass_rpcrt)
     {
         msg->Buffer = malloc(msg->BufferLength);
         if (msg->Buffer)
@@ -1321,6 +1314,32 @@ static DWORD WINAPI rpc_sendreceive_thread(LPVOID param)
     return 0;
 }
 
+/* this thread runs an incoming call into the multi-threaded apartment of the
+ * current process, without going through the RPC runtime */
+static DWORD WINAPI rpc_execute_mta_call_thread(LPVOID param)
+{
+    struct dispatch_params *params = param;
+    struct tlsdata *tlsdata;
+    BOOL joined = FALSE;
+
+    if (FAILED(params->hr = com_get_tlsdata(&tlsdata)))
+    {
+        SetEvent(params->handle);
+        return 0;
+    }
+
+    if (!tlsdata->apt)
+    {
+        enter_apartment(tlsdata, COINIT_MULTITHREADED);
+        joined = TRUE;
+    }
+    rpc_execute_call(params);
+    if (joined)
+        leave_apartment(tlsdata);
+
+    return 0;
+}
+
 static inline HRESULT ClientRpcChannelBuffer_IsCorrectApartment(ClientRpcChannelBuffer *This, const struct apartment *apt)
 {
     if (!apt)
@@ -1387,7 +1406,19 @@ static HRESULT WINAPI ClientRpcChannelBuffer_SendReceive(LPRPCCHANNELBUFFER ifac
      * from DllMain */
 
     message_state->params.msg = olemsg;
-    if (message_state->params.bypass_rpcrt)
+    if (message_state->params.bypass_rpcrt && !message_state->target_tid)
+    {
+        TRACE("Calling multi-threaded apartment...\n");
+
+        msg->ProcNum &= ~RPC_FLAGS_VALID_BIT;
+
+        if (!QueueUserWorkItem(rpc_execute_mta_call_thread, &message_state->params, WT_EXECUTEDEFAULT))
+        {
+            ERR("QueueUserWorkItem failed with error %lu\n", GetLastError());
+            hr = E_UNEXPECTED;
+        }
+    }
+    else if (message_state->params.bypass_rpcrt)
     {
         TRACE("Calling apartment thread %#lx...\n", message_state->target_tid);
 
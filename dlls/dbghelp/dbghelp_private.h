@@ -457,6 +457,7 @@ struct module
     unsigned                    num_symbols;
     unsigned                    sorttab_size;
     struct symt_ht**            addr_sorttab;
+    ULONG64*                    addr_sortaddr;  /* addresses of addr_sorttab entries (sorted part only) */
     struct hash_table           ht_symbols;
     struct symt_module*         top;
 
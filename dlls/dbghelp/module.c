@@ -228,6 +228,7 @@ struct module* module_new(struct process* pcs, const WCHAR* name,
     module->sortlist_valid    = FALSE;
     module->sorttab_size      = 0;
     module->addr_sorttab      = NULL;
+    module->addr_sortaddr     = NULL;
     module->num_sorttab       = 0;
     module->num_symbols       = 0;
     module->cpu               = cpu_find(machine);
@@ -1018,6 +1019,7 @@ BOOL module_remove(struct process* pcs, struct module* module)
     hash_table_destroy(&module->ht_types);
     HeapFree(GetProcessHeap(), 0, module->sources);
     HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
+    HeapFree(GetProcessHeap(), 0, module->addr_sortaddr);
     HeapFree(GetProcessHeap(), 0, module->real_path);
     pool_destroy(&module->pool);
     /* native dbghelp doesn't invoke registered callback(,CBA_SYMBOLS_UNLOADED,) here
@@ -1445,7 +1447,10 @@ void module_reset_debug_info(struct module* module)
 {
     module->sortlist_valid = TRUE;
     module->sorttab_size = 0;
+    HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
     module->addr_sorttab = NULL;
+    HeapFree(GetProcessHeap(), 0, module->addr_sortaddr);
+    module->addr_sortaddr = NULL;
     module->num_sorttab = module->num_symbols = 0;
     hash_table_destroy(&module->ht_symbols);
     module->ht_symbols.num_buckets = 0;
@@ -44,11 +44,10 @@ static inline int cmp_addr(ULONG64 a1, ULONG64 a2)
     return 0;
 }
 
+/* only valid for the sorted part of addr_sorttab (up to num_sorttab) */
 static inline int cmp_sorttab_addr(struct module* module, int idx, ULONG64 addr)
 {
-    ULONG64     ref;
-    symt_get_address(&module->addr_sorttab[idx]->symt, &ref);
-    return cmp_addr(ref, addr);
+    return cmp_addr(module->addr_sortaddr[idx], addr);
 }
 
 int __cdecl symt_cmp_addr(const void* p1, const void* p2)
@@ -130,6 +129,7 @@ struct symt*      symt_index2ptr(struct module* module, DWORD id)
 static BOOL symt_grow_sorttab(struct module* module, unsigned sz)
 {
     struct symt_ht**    new;
+    ULONG64*            new_addr;
     unsigned int size;
 
     if (sz <= module->sorttab_size) return TRUE;
@@ -138,15 +138,22 @@ static BOOL symt_grow_sorttab(struct module* module, unsigned sz)
         size = module->sorttab_size * 2;
         new = HeapReAlloc(GetProcessHeap(), 0, module->addr_sorttab,
                           size * sizeof(struct symt_ht*));
+        if (!new) return FALSE;
+        module->addr_sorttab = new;
+        new_addr = HeapReAlloc(GetProcessHeap(), 0, module->addr_sortaddr,
+                               size * sizeof(ULONG64));
     }
     else
     {
         size = 64;
         new = HeapAlloc(GetProcessHeap(), 0, size * sizeof(struct symt_ht*));
+        if (!new) return FALSE;
+        module->addr_sorttab = new;
+        new_addr = HeapAlloc(GetProcessHeap(), 0, size * sizeof(ULONG64));
     }
-    if (!new) return FALSE;
+    if (!new_addr) return FALSE;
     module->sorttab_size = size;
-    module->addr_sorttab = new;
+    module->addr_sortaddr = new_addr;
     return TRUE;
 }
 
@@ -942,13 +949,11 @@ static BOOL symt_enum_module(struct module_pair* pair, const WCHAR* match,
     return FALSE;
 }
 
-static inline unsigned where_to_insert(struct module* module, unsigned high, const struct symt_ht* elt)
+static inline unsigned where_to_insert(struct module* module, unsigned high, ULONG64 addr)
 {
     unsigned    low = 0, mid = high / 2;
-    ULONG64     addr;
 
     if (!high) return 0;
-    symt_get_address(&elt->symt, &addr);
     do
     {
         switch (cmp_sorttab_addr(module, mid, addr))
@@ -969,7 +974,7 @@ static inline unsigned where_to_insert(struct module* module, unsigned high, con
  */
 static BOOL resort_symbols(struct module* module)
 {
-    int delta;
+    int delta, i;
 
     if (!(module->module.NumSyms = module->num_symbols))
         return FALSE;
@@ -980,9 +985,15 @@ static BOOL resort_symbols(struct module* module)
      */
     delta = module->num_symbols - module->num_sorttab;
     qsort(&module->addr_sorttab[module->num_sorttab], delta, sizeof(struct symt_ht*), symt_cmp_addr);
+    /* refresh the cached addresses of the sorted set, as debug info loaders
+     * may have adjusted some of them before invalidating the list
+     */
+    for (i = 0; i < module->num_sorttab; i++)
+        symt_get_address(&module->addr_sorttab[i]->symt, &module->addr_sortaddr[i]);
     if (module->num_sorttab)
     {
-        int     i, ins_idx = module->num_sorttab, prev_ins_idx;
+        int     ins_idx = module->num_sorttab, prev_ins_idx;
+        ULONG64 addr;
         static struct symt_ht** tmp;
         static unsigned num_tmp;
 
@@ -1007,13 +1018,23 @@ static BOOL resort_symbols(struct module* module)
         for (i = delta - 1; i >= 0; i--)
         {
             prev_ins_idx = ins_idx;
-            ins_idx = where_to_insert(module, ins_idx, tmp[i]);
+            symt_get_address(&tmp[i]->symt, &addr);
+            ins_idx = where_to_insert(module, ins_idx, addr);
             memmove(&module->addr_sorttab[ins_idx + i + 1],
                     &module->addr_sorttab[ins_idx],
                     (prev_ins_idx - ins_idx) * sizeof(struct symt_ht*));
+            memmove(&module->addr_sortaddr[ins_idx + i + 1],
+                    &module->addr_sortaddr[ins_idx],
+                    (prev_ins_idx - ins_idx) * sizeof(ULONG64));
             module->addr_sorttab[ins_idx + i] = tmp[i];
+            module->addr_sortaddr[ins_idx + i] = addr;
         }
     }
+    else
+    {
+        for (i = 0; i < delta; i++)
+            symt_get_address(&module->addr_sorttab[i]->symt, &module->addr_sortaddr[i]);
+    }
     module->num_sorttab = module->num_symbols;
     return module->sortlist_valid = TRUE;
 }
@@ -1037,7 +1058,7 @@ static int symt_get_best_at(struct module* module, int idx_sorttab)
     int idx_sorttab_orig = idx_sorttab;
     if (module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol)
     {
-        symt_get_address(&module->addr_sorttab[idx_sorttab]->symt, &ref_addr);
+        ref_addr = module->addr_sortaddr[idx_sorttab];
         while (idx_sorttab > 0 &&
                module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol &&
                !cmp_sorttab_addr(module, idx_sorttab - 1, ref_addr))
@@ -1073,16 +1094,13 @@ struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
      */
     low = 0;
     high = module->num_sorttab;
+    if (!high) return NULL;
 
-    symt_get_address(&module->addr_sorttab[0]->symt, &ref_addr);
-    if (addr < ref_addr) return NULL;
+    if (addr < module->addr_sortaddr[0]) return NULL;
 
-    if (high)
-    {
-        symt_get_address(&module->addr_sorttab[high - 1]->symt, &ref_addr);
-        symt_get_length(module, &module->addr_sorttab[high - 1]->symt, &ref_size);
-        if (addr >= ref_addr + ref_size) return NULL;
-    }
+    ref_addr = module->addr_sortaddr[high - 1];
+    symt_get_length(module, &module->addr_sorttab[high - 1]->symt, &ref_size);
+    if (addr >= ref_addr + ref_size) return NULL;
     
     while (high > low + 1)
     {
@@ -0,0 +1,295 @@
+/*
+ * DNS resolver cache
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+#include "windef.h"
+#include "winbase.h"
+#include "winerror.h"
+#include "winnls.h"
+#include "windns.h"
+
+#include "wine/debug.h"
+#include "wine/list.h"
+#include "dnsapi.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(dnsapi);
+
+#define CACHE_BUCKETS       64
+#define CACHE_MAX_ENTRIES   1024
+#define CACHE_MAX_TTL       86400
+#define CACHE_NEGATIVE_TTL  60
+
+/* query options that change the result, entries are only shared between queries using the same ones */
+#define CACHE_OPTIONS_MASK  (DNS_QUERY_ACCEPT_TRUNCATED_RESPONSE | DNS_QUERY_NO_RECURSION | \
+                             DNS_QUERY_NO_HOSTS_FILE | DNS_QUERY_NO_NETBT | \
+                             DNS_QUERY_DNSSEC_OK | DNS_QUERY_DNSSEC_CHECKING_DISABLED)
+
+struct cache_entry
+{
+    struct list entry;
+    char *name;             /* UTF-8 */
+    WORD type;
+    DWORD options;          /* options of the query, see CACHE_OPTIONS_MASK */
+    DNS_STATUS status;      /* non-zero for negative entries */
+    DNS_RECORDA *records;   /* UTF-8 records for positive entries */
+    ULONGLONG expires;      /* in seconds */
+};
+
+static struct list cache[CACHE_BUCKETS];
+static unsigned int cache_count;
+
+static CRITICAL_SECTION cache_cs;
+static CRITICAL_SECTION_DEBUG cache_cs_debug =
+{
+    0, 0, &cache_cs,
+    { &cache_cs_debug.ProcessLocksList, &cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": cache_cs") }
+};
+static CRITICAL_SECTION cache_cs = { &cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static inline ULONGLONG current_time(void)
+{
+    return GetTickCount64() / 1000;
+}
+
+static inline char lower_ascii( char c )
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+static BOOL names_equal( const char *a, const char *b )
+{
+    while (*a && lower_ascii( *a ) == lower_ascii( *b )) { a++; b++; }
+    return lower_ascii( *a ) == lower_ascii( *b );
+}
+
+/* caller must hold cache_cs */
+static struct list *get_bucket( const char *name )
+{
+    unsigned int hash = 0;
+    struct list *bucket;
+
+    while (*name) hash = hash * 31 + lower_ascii( *name++ );
+    bucket = &cache[hash % CACHE_BUCKETS];
+    if (!bucket->next) list_init( bucket );
+    return bucket;
+}
+
+static void free_entry( struct cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    cache_count--;
+    DnsRecordListFree( (DNS_RECORD *)entry->records, DnsFreeRecordList );
+    free( entry->name );
+    free( entry );
+}
+
+/* caller must hold cache_cs */
+static void remove_expired( ULONGLONG now )
+{
+    struct cache_entry *entry, *next;
+    unsigned int i;
+
+    for (i = 0; i < CACHE_BUCKETS; i++)
+    {
+        if (!cache[i].next) continue;
+        LIST_FOR_EACH_ENTRY_SAFE( entry, next, &cache[i], struct cache_entry, entry )
+            if (entry->expires <= now) free_entry( entry );
+    }
+}
+
+/* caller must hold cache_cs */
+static struct cache_entry *find_entry( const char *name, WORD type, DWORD options )
+{
+    struct cache_entry *entry;
+
+    LIST_FOR_EACH_ENTRY( entry, get_bucket( name ), struct cache_entry, entry )
+        if (entry->type == type && entry->options == options && names_equal( entry->name, name )) return entry;
+    return NULL;
+}
+
+/* look up a cached query result; returns FALSE on a cache miss */
+BOOL cache_lookup( const char *name, WORD type, DWORD options, DNS_STATUS *status, DNS_RECORDA **result )
+{
+    ULONGLONG now = current_time();
+    struct cache_entry *entry;
+    DNS_RECORDA *r;
+    BOOL ret = FALSE;
+
+    EnterCriticalSection( &cache_cs );
+
+    if ((entry = find_entry( name, type, options & CACHE_OPTIONS_MASK )))
+    {
+        if (entry->expires <= now) free_entry( entry );
+        else if ((*status = entry->status))
+        {
+            *result = NULL;
+            ret = TRUE;
+        }
+        else if ((*result = (DNS_RECORDA *)DnsRecordSetCopyEx( (DNS_RECORD *)entry->records,
+                                                               DnsCharSetUtf8, DnsCharSetUtf8 )))
+        {
+            /* report the time left rather than the original ttl */
+            for (r = *result; r; r = r->pNext) r->dwTtl = min( r->dwTtl, entry->expires - now );
+            ret = TRUE;
+        }
+    }
+
+    LeaveCriticalSection( &cache_cs );
+
+    if (ret) TRACE( "cache hit for %s %s\n", debugstr_a(name), debugstr_type( type ) );
+    return ret;
+}
+
+/* cache the result of a query, a copy of the records is stored */
+void cache_insert( const char *name, WORD type, DWORD options, DNS_STATUS status, DNS_RECORDA *records )
+{
+    ULONGLONG now = current_time();
+    struct cache_entry *entry;
+    DWORD ttl = CACHE_MAX_TTL;
+    DNS_RECORDA *r;
+
+    if (!status)
+    {
+        for (r = records; r; r = r->pNext) ttl = min( ttl, r->dwTtl );
+    }
+    else if (status == DNS_ERROR_RCODE_NAME_ERROR) ttl = CACHE_NEGATIVE_TTL;
+    else return;
+
+    if (!ttl) return;
+
+    if (!(entry = calloc( 1, sizeof(*entry) ))) return;
+    entry->type = type;
+    entry->options = options & CACHE_OPTIONS_MASK;
+    entry->status = status;
+    entry->expires = now + ttl;
+    if (!(entry->name = strdup_u( name )) ||
+        (records && !(entry->records = (DNS_RECORDA *)DnsRecordSetCopyEx( (DNS_RECORD *)records,
+                                                                          DnsCharSetUtf8, DnsCharSetUtf8 ))))
+    {
+        free( entry->name );
+        free( entry );
+        return;
+    }
+
+    EnterCriticalSection( &cache_cs );
+
+    if (cache_count >= CACHE_MAX_ENTRIES) remove_expired( now );
+    if (cache_count < CACHE_MAX_ENTRIES)
+    {
+        struct cache_entry *old;
+
+        if ((old = find_entry( name, type, entry->options ))) free_entry( old );
+        list_add_head( get_bucket( name ), &entry->entry );
+        cache_count++;
+        entry = NULL;
+    }
+
+    LeaveCriticalSection( &cache_cs );
+
+    if (entry)
+    {
+        WARN( "cache is full\n" );
+        DnsRecordListFree( (DNS_RECORD *)entry->records, DnsFreeRecordList );
+        free( entry->name );
+        free( entry );
+    }
+}
+
+/* remove all entries for a name, or every entry if name is NULL */
+void cache_flush( const char *name )
+{
+    struct cache_entry *entry, *next;
+    unsigned int i;
+
+    EnterCriticalSection( &cache_cs );
+
+    for (i = 0; i < CACHE_BUCKETS; i++)
+    {
+        if (!cache[i].next) continue;
+        LIST_FOR_EACH_ENTRY_SAFE( entry, next, &cache[i], struct cache_entry, entry )
+            if (!name || names_equal( entry->name, name )) free_entry( entry );
+    }
+
+    LeaveCriticalSection( &cache_cs );
+}
+
+/* caller must hold cache_cs */
+static BOOL is_listed( struct cache_entry *entry, struct list *bucket )
+{
+    struct cache_entry *prev;
+
+    /* the same name and type may be cached for different query options */
+    LIST_FOR_EACH_ENTRY( prev, bucket, struct cache_entry, entry )
+    {
+        if (prev == entry) return FALSE;
+        if (!prev->status && prev->type == entry->type && names_equal( prev->name, entry->name )) return TRUE;
+    }
+    return FALSE;
+}
+
+/* build a list of the names in the cache, each node is freed with DnsFree( node, DnsFreeFlat ) */
+BOOL cache_get_table( DNS_CACHE_ENTRY **table )
+{
+    ULONGLONG now = current_time();
+    DNS_CACHE_ENTRY *node, **next = table;
+    struct cache_entry *entry;
+    unsigned int i, len;
+    BOOL ret = TRUE;
+
+    *table = NULL;
+
+    EnterCriticalSection( &cache_cs );
+
+    remove_expired( now );
+    for (i = 0; i < CACHE_BUCKETS && ret; i++)
+    {
+        if (!cache[i].next) continue;
+        LIST_FOR_EACH_ENTRY( entry, &cache[i], struct cache_entry, entry )
+        {
+            if (entry->status || is_listed( entry, &cache[i] )) continue;
+
+            len = MultiByteToWideChar( CP_UTF8, 0, entry->name, -1, NULL, 0 );
+            if (!(node = malloc( sizeof(*node) + len * sizeof(WCHAR) )))
+            {
+                ret = FALSE;
+                break;
+            }
+            node->Next = NULL;
+            node->Name = (WCHAR *)(node + 1);
+            MultiByteToWideChar( CP_UTF8, 0, entry->name, -1, (WCHAR *)node->Name, len );
+            node->Type = entry->type;
+            node->DataLength = entry->records ? entry->records->wDataLength : 0;
+            node->Flags = 0;
+            *next = node;
+            next = &node->Next;
+        }
+    }
+
+    LeaveCriticalSection( &cache_cs );
+
+    if (!ret)
+    {
+        while ((node = *table))
+        {
+            *table = node->Next;
+            free( node );
+        }
+    }
+    return ret;
+}
@@ -94,7 +94,8 @@ DNS_STATUS WINAPI DnsAcquireContextHandle_W( DWORD flags, void *cred, HANDLE *co
  */
 VOID WINAPI DnsFlushResolverCache(void)
 {
-    FIXME(": stub\n");
+    TRACE( "\n" );
+    cache_flush( NULL );
 }
 
 /******************************************************************************
@@ -103,8 +104,14 @@ VOID WINAPI DnsFlushResolverCache(void)
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    char *entryU;
+
+    TRACE( "%s\n", debugstr_a(entry) );
+
     if (!entry) return FALSE;
+    if (!(entryU = strdup_au( entry ))) return FALSE;
+    cache_flush( entryU );
+    free( entryU );
     return TRUE;
 }
 
@@ -114,8 +121,10 @@ BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    TRACE( "%s\n", debugstr_a(entry) );
+
     if (!entry) return FALSE;
+    cache_flush( entry );
     return TRUE;
 }
 
@@ -125,8 +134,14 @@ BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_W( PCWSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_w(entry) );
+    char *entryU;
+
+    TRACE( "%s\n", debugstr_w(entry) );
+
     if (!entry) return FALSE;
+    if (!(entryU = strdup_wu( entry ))) return FALSE;
+    cache_flush( entryU );
+    free( entryU );
     return TRUE;
 }
 
@@ -136,8 +151,10 @@ BOOL WINAPI DnsFlushResolverCacheEntry_W( PCWSTR entry )
  */
 BOOL WINAPI DnsGetCacheDataTable( PDNS_CACHE_ENTRY* entry )
 {
-    FIXME( "(%p) stub\n", entry );
-    return FALSE;
+    TRACE( "(%p)\n", entry );
+
+    if (!entry) return FALSE;
+    return cache_get_table( entry );
 }
 
 /******************************************************************************
@@ -176,6 +176,12 @@ DNS_STATUS WINAPI DnsQuery_UTF8( const char *name, WORD type, DWORD options, voi
     if (!name || !result)
         return ERROR_INVALID_PARAMETER;
 
+    /* only results from the default servers are cached */
+    if (!servers && !(options & (DNS_QUERY_BYPASS_CACHE | DNS_QUERY_WIRE_ONLY)) &&
+        cache_lookup( name, type, options, &ret, result ))
+        return ret;
+    if (options & DNS_QUERY_NO_WIRE_QUERY) return DNS_ERROR_RECORD_DOES_NOT_EXIST;
+
     if ((ret = RESOLV_CALL( set_serverlist, servers ))) return ret;
 
     ret = RESOLV_CALL( query, &query_params );
@@ -209,6 +215,7 @@ DNS_STATUS WINAPI DnsQuery_UTF8( const char *name, WORD type, DWORD options, voi
         ret = do_query_netbios( name, result );
     }
 
+    if (!servers) cache_insert( name, type, options, ret, ret ? NULL : *result );
     return ret;
 }
 
@@ -722,6 +722,9 @@ VOID WINAPI DnsRecordListFree( PDNS_RECORD list, DNS_FREE_TYPE type )
         break;
     }
     case DnsFreeFlat:
+        free( list );
+        break;
+
     case DnsFreeParsedMessageFields:
     {
         FIXME( "unhandled free type: %d\n", type );
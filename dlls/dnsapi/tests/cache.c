@@ -20,6 +20,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <wchar.h>
 
 #include "windef.h"
 #include "winbase.h"
@@ -28,19 +29,52 @@
 
 #include "wine/test.h"
 
+static void free_cache_table( DNS_CACHE_ENTRY *entry )
+{
+    DNS_CACHE_ENTRY *next;
+
+    for (; entry; entry = next)
+    {
+        next = entry->Next;
+        DnsFree( entry, DnsFreeFlat );
+    }
+}
+
 static void test_DnsGetCacheDataTable( void )
 {
-    BOOL ret;
-    PDNS_CACHE_ENTRY entry = NULL;
+    BOOL ret, found = FALSE;
+    PDNS_CACHE_ENTRY entry = NULL, e;
+    DNS_RECORDA *rec;
+    DNS_STATUS status;
 
     ret = DnsGetCacheDataTable( NULL );
     ok( !ret, "DnsGetCacheDataTable succeeded\n" );
 
+    /* a cache only query never goes to the network */
+    rec = (DNS_RECORDA *)0xdeadbeef;
+    status = DnsQuery_A( "nonexistent.test.winehq.org", DNS_TYPE_A, DNS_QUERY_NO_WIRE_QUERY, NULL, &rec, NULL );
+    ok( status, "cache only query succeeded\n" );
+
+    status = DnsQuery_A( "test.winehq.org", DNS_TYPE_A, DNS_QUERY_STANDARD, NULL, &rec, NULL );
+    if (status)
+    {
+        skip( "query failed %ld, no network?\n", status );
+        return;
+    }
+    DnsRecordListFree( (DNS_RECORD *)rec, DnsFreeRecordList );
+
+    status = DnsQuery_A( "test.winehq.org", DNS_TYPE_A, DNS_QUERY_NO_WIRE_QUERY, NULL, &rec, NULL );
+    ok( !status, "cache only query failed %ld\n", status );
+    if (!status) DnsRecordListFree( (DNS_RECORD *)rec, DnsFreeRecordList );
+
     ret = DnsGetCacheDataTable( &entry );
-    todo_wine
     ok( ret, "DnsGetCacheDataTable failed\n" );
-    todo_wine
     ok( entry != NULL, "DnsGetCacheDataTable returned NULL\n" );
+
+    for (e = entry; e; e = e->Next)
+        if (!wcsicmp( e->Name, L"test.winehq.org" ) && e->Type == DNS_TYPE_A) found = TRUE;
+    ok( found, "test.winehq.org not found in cache\n" );
+    free_cache_table( entry );
 }
 
 START_TEST(cache)
@@ -100,21 +100,21 @@ struct request_queue
 
 static struct list request_queues = LIST_INIT(request_queues);
 
-static void accept_connection(SOCKET socket)
+static struct connection *accept_connection(SOCKET socket)
 {
     struct connection *conn;
     ULONG true = 1;
     SOCKET peer;
 
     if ((peer = accept(socket, NULL, NULL)) == INVALID_SOCKET)
-        return;
+        return NULL;
 
     if (!(conn = heap_alloc_zero(sizeof(*conn))))
     {
         ERR("Failed to allocate memory.\n");
         shutdown(peer, SD_BOTH);
         closesocket(peer);
-        return;
+        return NULL;
     }
     if (!(conn->buffer = heap_alloc(8192)))
     {
@@ -122,13 +122,14 @@ static void accept_connection(SOCKET socket)
         heap_free(conn);
         shutdown(peer, SD_BOTH);
         closesocket(peer);
-        return;
+        return NULL;
     }
     conn->size = 8192;
     WSAEventSelect(peer, request_event, FD_READ | FD_CLOSE);
     ioctlsocket(peer, FIONBIO, &true);
     conn->socket = peer;
     list_add_head(&connections, &conn->entry);
+    return conn;
 }
 
 static void close_connection(struct connection *conn)
@@ -562,11 +563,46 @@ static void receive_data(struct connection *conn)
     }
 }
 
+struct poll_set
+{
+    WSAPOLLFD *fds;
+    struct connection **conns; /* NULL for listening sockets */
+    unsigned int count, size;
+};
+
+static BOOL poll_set_add(struct poll_set *set, SOCKET socket, struct connection *conn)
+{
+    if (set->count == set->size)
+    {
+        unsigned int new_size = max(set->size * 2, 64);
+        WSAPOLLFD *new_fds;
+        struct connection **new_conns;
+
+        if (!(new_fds = heap_realloc(set->fds, new_size * sizeof(*new_fds))))
+            return FALSE;
+        set->fds = new_fds;
+        if (!(new_conns = heap_realloc(set->conns, new_size * sizeof(*new_conns))))
+            return FALSE;
+        set->conns = new_conns;
+        set->size = new_size;
+    }
+
+    set->fds[set->count].fd = socket;
+    set->fds[set->count].events = POLLRDNORM;
+    set->fds[set->count].revents = 0;
+    set->conns[set->count] = conn;
+    ++set->count;
+    return TRUE;
+}
+
 static DWORD WINAPI request_thread_proc(void *arg)
 {
     struct connection *conn, *cursor;
+    struct poll_set set = {0};
     struct request_queue *queue;
+    unsigned int i;
     struct url *url;
+    BOOL polled;
 
     TRACE("Starting request thread.\n");
 
@@ -574,23 +610,69 @@ static DWORD WINAPI request_thread_proc(void *arg)
     {
         EnterCriticalSection(&http_cs);
 
+        /* All sockets signal the same event, so find out which of them are
+         * ready with a single poll instead of trying each of them. */
+        set.count = 0;
+        polled = TRUE;
         LIST_FOR_EACH_ENTRY(queue, &request_queues, struct request_queue, entry)
         {
             LIST_FOR_EACH_ENTRY(url, &queue->urls, struct url, entry)
             {
-                if (url->socket != -1)
-                    accept_connection(url->socket);
+                if (url->socket != -1 && !(polled = poll_set_add(&set, url->socket, NULL)))
+                    break;
             }
+            if (!polled) break;
+        }
+        LIST_FOR_EACH_ENTRY(conn, &connections, struct connection, entry)
+        {
+            if (!polled || !(polled = poll_set_add(&set, conn->socket, conn)))
+                break;
+        }
+        if (polled && set.count && WSAPoll(set.fds, set.count, 0) < 0)
+        {
+            WARN("Poll failed, error %d.\n", WSAGetLastError());
+            polled = FALSE;
         }
 
-        LIST_FOR_EACH_ENTRY_SAFE(conn, cursor, &connections, struct connection, entry)
+        if (polled)
         {
-            receive_data(conn);
+            for (i = 0; i < set.count; ++i)
+            {
+                if (!set.fds[i].revents || set.conns[i])
+                    continue;
+                /* Newly accepted connections may already have data. */
+                if ((conn = accept_connection(set.fds[i].fd)))
+                    receive_data(conn);
+            }
+            for (i = 0; i < set.count; ++i)
+            {
+                if (set.fds[i].revents && set.conns[i])
+                    receive_data(set.conns[i]);
+            }
+        }
+        else
+        {
+            LIST_FOR_EACH_ENTRY(queue, &request_queues, struct request_queue, entry)
+            {
+                LIST_FOR_EACH_ENTRY(url, &queue->urls, struct url, entry)
+                {
+                    if (url->socket != -1)
+                        accept_connection(url->socket);
+                }
+            }
+
+            LIST_FOR_EACH_ENTRY_SAFE(conn, cursor, &connections, struct connection, entry)
+            {
+                receive_data(conn);
+            }
         }
 
         LeaveCriticalSection(&http_cs);
     }
 
+    heap_free(set.fds);
+    heap_free(set.conns);
+
     TRACE("Stopping request thread.\n");
 
     return 0;
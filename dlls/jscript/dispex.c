@@ -24,6 +24,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(jscript);
+WINE_DECLARE_DEBUG_CHANNEL(jscript_gc);
 
 static const GUID GUID_JScriptTypeInfo = {0xc59c6b12,0xf6c1,0x11cf,{0x88,0x35,0x00,0xa0,0xc9,0x11,0xe8,0xb2}};
 
@@ -1812,6 +1813,8 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     script_addref(ctx);
     dispex->ctx = ctx;
 
+    list_add_tail(&ctx->objects, &dispex->entry);
+    ctx->object_cnt++;
     return S_OK;
 }
 
@@ -1848,6 +1851,9 @@ void jsdisp_free(jsdisp_t *obj)
 
     TRACE("(%p)\n", obj);
 
+    list_remove(&obj->entry);
+    obj->ctx->object_cnt--;
+
     for(prop = obj->props; prop < obj->props+obj->prop_cnt; prop++) {
         switch(prop->type) {
         case PROP_JSVAL:
@@ -1875,6 +1881,263 @@ void jsdisp_free(jsdisp_t *obj)
         heap_free(obj);
 }
 
+enum gc_op {
+    GC_COLLECT_SCOPES,
+    GC_DECREF,
+    GC_MARK
+};
+
+struct gc_stack {
+    void **items;
+    unsigned cnt;
+    unsigned size;
+    BOOL failed;
+};
+
+struct gc_ctx {
+    script_ctx_t *ctx;
+    enum gc_op op;
+    struct gc_stack scopes;         /* scope chains referenced by the objects */
+    struct gc_stack obj_queue;      /* objects found alive, not yet traversed */
+    struct gc_stack scope_queue;    /* scope chains found alive, not yet traversed */
+};
+
+static BOOL gc_push(struct gc_stack *stack, void *item)
+{
+    void **new_items;
+    unsigned new_size;
+
+    if(stack->cnt == stack->size) {
+        new_size = stack->size ? stack->size * 2 : 64;
+        new_items = heap_realloc(stack->items, new_size * sizeof(*new_items));
+        if(!new_items) {
+            stack->failed = TRUE;
+            return FALSE;
+        }
+        stack->items = new_items;
+        stack->size = new_size;
+    }
+    stack->items[stack->cnt++] = item;
+    return TRUE;
+}
+
+/*
+ * Visits a reference held by an object or a scope chain. Objects of other
+ * scripts and host objects are not part of the graph and are ignored.
+ */
+void gc_visit_obj(struct gc_ctx *gc, jsdisp_t *obj)
+{
+    if(!obj || obj->ctx != gc->ctx)
+        return;
+
+    switch(gc->op) {
+    case GC_COLLECT_SCOPES:
+        break;
+    case GC_DECREF:
+        obj->gc_ref--;
+        break;
+    case GC_MARK:
+        if(obj->gc_ref <= 0) {
+            obj->gc_ref = 1;
+            gc_push(&gc->obj_queue, obj);
+        }
+        break;
+    }
+}
+
+void gc_visit_val(struct gc_ctx *gc, jsval_t val)
+{
+    if(is_object_instance(val) && get_object(val))
+        gc_visit_obj(gc, to_jsdisp(get_object(val)));
+}
+
+/*
+ * Scope chains are not objects, but they hold the activation objects of
+ * closures and are shared between the functions created in the same scope,
+ * so they take part in the collection as nodes of their own.
+ */
+void gc_visit_scope(struct gc_ctx *gc, scope_chain_t *scope)
+{
+    if(!scope)
+        return;
+
+    switch(gc->op) {
+    case GC_COLLECT_SCOPES:
+        if(scope->gc_gen != gc->ctx->gc_gen) {
+            scope->gc_gen = gc->ctx->gc_gen;
+            scope->gc_ref = scope->ref;
+            gc_push(&gc->scopes, scope);
+        }
+        break;
+    case GC_DECREF:
+        scope->gc_ref--;
+        break;
+    case GC_MARK:
+        if(scope->gc_ref <= 0) {
+            scope->gc_ref = 1;
+            gc_push(&gc->scope_queue, scope);
+        }
+        break;
+    }
+}
+
+static void gc_traverse_scope(struct gc_ctx *gc, scope_chain_t *scope)
+{
+    gc_visit_scope(gc, scope->next);
+    if(scope->obj)
+        gc_visit_obj(gc, to_jsdisp(scope->obj));
+}
+
+/*
+ * Visits each reference held by obj: its properties, its prototype and, through
+ * the gc_traverse hook of its class, references kept outside of properties.
+ */
+static void gc_traverse(struct gc_ctx *gc, jsdisp_t *obj)
+{
+    dispex_prop_t *prop;
+
+    for(prop = obj->props; prop < obj->props + obj->prop_cnt; prop++) {
+        switch(prop->type) {
+        case PROP_JSVAL:
+            gc_visit_val(gc, prop->u.val);
+            break;
+        case PROP_ACCESSOR:
+            gc_visit_obj(gc, prop->u.accessor.getter);
+            gc_visit_obj(gc, prop->u.accessor.setter);
+            break;
+        default:
+            break;
+        }
+    }
+
+    gc_visit_obj(gc, obj->prototype);
+
+    if(obj->builtin_info->gc_traverse)
+        obj->builtin_info->gc_traverse(gc, obj);
+}
+
+static void gc_unlink(jsdisp_t *obj)
+{
+    dispex_prop_t *prop;
+    jsdisp_t *prototype;
+
+    for(prop = obj->props; prop < obj->props + obj->prop_cnt; prop++) {
+        switch(prop->type) {
+        case PROP_JSVAL:
+            prop->type = PROP_DELETED;
+            jsval_release(prop->u.val);
+            break;
+        case PROP_ACCESSOR:
+            prop->type = PROP_DELETED;
+            if(prop->u.accessor.getter)
+                jsdisp_release(prop->u.accessor.getter);
+            if(prop->u.accessor.setter)
+                jsdisp_release(prop->u.accessor.setter);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if((prototype = obj->prototype)) {
+        obj->prototype = NULL;
+        jsdisp_release(prototype);
+    }
+
+    if(obj->builtin_info->gc_unlink)
+        obj->builtin_info->gc_unlink(obj);
+}
+
+/*
+ * Collects cycles of objects that are not referenced from outside of the
+ * object graph. Every object's and scope chain's reference count is reduced by
+ * the references held by other objects and scope chains of the script; the
+ * ones left with a positive count are referenced from elsewhere (the engine's
+ * stack and call frames, the host, objects of other scripts) and everything
+ * reachable from them is alive. The remaining objects are unlinked, which
+ * breaks the cycles.
+ */
+void gc_run(script_ctx_t *ctx)
+{
+    struct gc_ctx gc = {ctx};
+    struct gc_stack garbage = {NULL};
+    unsigned obj_cnt = ctx->object_cnt, i;
+    jsdisp_t *obj;
+    BOOL failed;
+    DWORD time;
+
+    if(ctx->gc_is_running || !obj_cnt)
+        return;
+
+    ctx->gc_is_running = TRUE;
+    ctx->gc_gen++;
+    time = GetTickCount();
+
+    gc.op = GC_COLLECT_SCOPES;
+    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+        obj->gc_ref = obj->ref;
+        gc_traverse(&gc, obj);
+    }
+    for(i = 0; i < gc.scopes.cnt; i++)
+        gc_traverse_scope(&gc, gc.scopes.items[i]);
+    failed = gc.scopes.failed;
+
+    if(!failed) {
+        gc.op = GC_DECREF;
+        LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry)
+            gc_traverse(&gc, obj);
+        for(i = 0; i < gc.scopes.cnt; i++)
+            gc_traverse_scope(&gc, gc.scopes.items[i]);
+
+        gc.op = GC_MARK;
+        LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+            if(obj->gc_ref > 0)
+                gc_push(&gc.obj_queue, obj);
+        }
+        for(i = 0; i < gc.scopes.cnt; i++) {
+            if(((scope_chain_t*)gc.scopes.items[i])->gc_ref > 0)
+                gc_push(&gc.scope_queue, gc.scopes.items[i]);
+        }
+        while(!gc.obj_queue.failed && !gc.scope_queue.failed) {
+            if(gc.obj_queue.cnt)
+                gc_traverse(&gc, gc.obj_queue.items[--gc.obj_queue.cnt]);
+            else if(gc.scope_queue.cnt)
+                gc_traverse_scope(&gc, gc.scope_queue.items[--gc.scope_queue.cnt]);
+            else
+                break;
+        }
+        failed = gc.obj_queue.failed || gc.scope_queue.failed;
+    }
+
+    if(!failed) {
+        LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+            if(obj->gc_ref <= 0 && gc_push(&garbage, obj))
+                jsdisp_addref(obj);
+        }
+        failed = garbage.failed;
+    }
+
+    if(!failed) {
+        for(i = 0; i < garbage.cnt; i++)
+            gc_unlink(garbage.items[i]);
+    }else {
+        ERR("out of memory\n");
+    }
+
+    for(i = 0; i < garbage.cnt; i++)
+        jsdisp_release(garbage.items[i]);
+    heap_free(garbage.items);
+    heap_free(gc.scopes.items);
+    heap_free(gc.obj_queue.items);
+    heap_free(gc.scope_queue.items);
+
+    ctx->gc_threshold = max(GC_MIN_THRESHOLD, ctx->object_cnt * 2);
+    ctx->gc_is_running = FALSE;
+
+    TRACE_(jscript_gc)("%u objects, %u scopes, %u collected, %lu ms, next collection at %u objects\n",
+                       obj_cnt, gc.scopes.cnt, garbage.cnt, GetTickCount() - time, ctx->gc_threshold);
+}
+
 #ifdef TRACE_REFCNT
 
 jsdisp_t *jsdisp_addref(jsdisp_t *jsdisp)
@@ -1957,6 +2220,36 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Property ids are indexes into the object's property table and properties are
+ * never removed from it, so objects created the same way (by the same
+ * constructor or object literal) end up with a property at the same id. Callers
+ * looking up a constant name keep the last id found in *cache, which is checked
+ * before doing the hash lookup.
+ */
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, unsigned *cache, DISPID *id)
+{
+    DWORD idx = *cache - 1;
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(idx < jsdisp->prop_cnt) {
+        prop = &jsdisp->props[idx];
+        if(prop->type != PROP_DELETED && !wcscmp(prop->name, name)) {
+            fix_protref_prop(jsdisp, prop);
+            if(prop->type != PROP_DELETED) {
+                *id = prop_to_id(jsdisp, prop);
+                return S_OK;
+            }
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres))
+        *cache = *id;
+    return hres;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
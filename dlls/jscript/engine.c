@@ -439,6 +439,7 @@ static HRESULT scope_push(scope_chain_t *scope, jsdisp_t *jsobj, IDispatch *obj,
     new_scope->frame = NULL;
     new_scope->next = scope ? scope_addref(scope) : NULL;
     new_scope->scope_index = 0;
+    new_scope->gc_gen = 0;
 
     *ret = new_scope;
     return S_OK;
@@ -503,6 +504,22 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+/* Same as disp_get_id, but tries the id cached in the instruction first. */
+static HRESULT disp_get_id_cached(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr,
+                                  DWORD flags, unsigned *cache, DISPID *id)
+{
+    jsdisp_t *jsdisp;
+    HRESULT hres;
+
+    jsdisp = iface_to_jsdisp(disp);
+    if(!jsdisp)
+        return disp_get_id(ctx, disp, name, name_bstr, flags, id);
+
+    hres = jsdisp_get_id_cached(jsdisp, name, flags, cache, id);
+    jsdisp_release(jsdisp);
+    return hres;
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -807,6 +824,12 @@ static inline unsigned get_op_uint(script_ctx_t *ctx, int i)
     return frame->bytecode->instrs[frame->ip].u.arg[i].uint;
 }
 
+static inline unsigned *get_op_cache(script_ctx_t *ctx, int i)
+{
+    call_frame_t *frame = ctx->call_ctx;
+    return &frame->bytecode->instrs[frame->ip].u.arg[i].uint;
+}
+
 static inline unsigned get_op_int(script_ctx_t *ctx, int i)
 {
     call_frame_t *frame = ctx->call_ctx;
@@ -1281,7 +1304,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_id_cached(ctx, obj, arg, arg, 0, get_op_cache(ctx, 1), &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1323,7 +1346,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_id_cached(ctx, obj, name, NULL, arg, get_op_cache(ctx, 1), &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -3236,6 +3259,10 @@ HRESULT exec_source(script_ctx_t *ctx, DWORD flags, bytecode_t *bytecode, functi
             return E_OUTOFMEMORY;
     }
 
+    /* Everything in use is referenced from the stack and call frames here, so it's a safe point to collect. */
+    if(ctx->object_cnt >= ctx->gc_threshold)
+        gc_run(ctx);
+
     if(bytecode->named_item) {
         if(!bytecode->named_item->script_obj) {
             hres = create_named_item_script_obj(ctx, bytecode->named_item);
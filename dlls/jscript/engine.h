@@ -55,8 +55,8 @@
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
     X(lteq,       1, 0,0)                  \
-    X(member,     1, ARG_BSTR,   0)        \
-    X(memberid,   1, ARG_UINT,   0)        \
+    X(member,     1, ARG_BSTR,   ARG_UINT) \
+    X(memberid,   1, ARG_UINT,   ARG_UINT) \
     X(minus,      1, 0,0)                  \
     X(mod,        1, 0,0)                  \
     X(mul,        1, 0,0)                  \
@@ -228,9 +228,12 @@ typedef struct _scope_chain_t {
     unsigned int scope_index;
     struct _call_frame_t *frame;
     struct _scope_chain_t *next;
+    LONG gc_ref;
+    unsigned gc_gen; /* last collection that visited the scope */
 } scope_chain_t;
 
 void scope_release(scope_chain_t*) DECLSPEC_HIDDEN;
+void gc_visit_scope(struct gc_ctx*,scope_chain_t*) DECLSPEC_HIDDEN;
 
 static inline scope_chain_t *scope_addref(scope_chain_t *scope)
 {
@@ -39,6 +39,7 @@ struct _function_vtbl_t {
     HRESULT (*toString)(FunctionInstance*,jsstr_t**);
     function_code_t* (*get_code)(FunctionInstance*);
     void (*destructor)(FunctionInstance*);
+    void (*gc_traverse)(struct gc_ctx*,FunctionInstance*);
 };
 
 typedef struct {
@@ -112,6 +113,33 @@ static void Arguments_destructor(jsdisp_t *jsdisp)
     heap_free(arguments);
 }
 
+static void Arguments_gc_traverse(struct gc_ctx *gc, jsdisp_t *jsdisp)
+{
+    ArgumentsInstance *arguments = arguments_from_jsdisp(jsdisp);
+    unsigned i;
+
+    gc_visit_obj(gc, &arguments->function->function.dispex);
+    if(arguments->buf) {
+        for(i = 0; i < arguments->argc; i++)
+            gc_visit_val(gc, arguments->buf[i]);
+    }
+}
+
+static void Arguments_gc_unlink(jsdisp_t *jsdisp)
+{
+    ArgumentsInstance *arguments = arguments_from_jsdisp(jsdisp);
+    jsval_t val;
+    unsigned i;
+
+    if(arguments->buf) {
+        for(i = 0; i < arguments->argc; i++) {
+            val = arguments->buf[i];
+            arguments->buf[i] = jsval_undefined();
+            jsval_release(val);
+        }
+    }
+}
+
 static unsigned Arguments_idx_length(jsdisp_t *jsdisp)
 {
     ArgumentsInstance *arguments = arguments_from_jsdisp(jsdisp);
@@ -174,7 +202,9 @@ static const builtin_info_t Arguments_info = {
     NULL,
     Arguments_idx_length,
     Arguments_idx_get,
-    Arguments_idx_put
+    Arguments_idx_put,
+    Arguments_gc_traverse,
+    Arguments_gc_unlink
 };
 
 HRESULT setup_arguments_object(script_ctx_t *ctx, call_frame_t *frame)
@@ -553,6 +583,14 @@ static void Function_destructor(jsdisp_t *dispex)
     heap_free(function);
 }
 
+static void Function_gc_traverse(struct gc_ctx *gc, jsdisp_t *dispex)
+{
+    FunctionInstance *function = function_from_jsdisp(dispex);
+
+    if(function->vtbl->gc_traverse)
+        function->vtbl->gc_traverse(gc, function);
+}
+
 static const builtin_prop_t Function_props[] = {
     {L"apply",               Function_apply,                 PROPF_METHOD|2},
     {L"arguments",           NULL, 0,                        Function_get_arguments},
@@ -568,7 +606,11 @@ static const builtin_info_t Function_info = {
     ARRAY_SIZE(Function_props),
     Function_props,
     Function_destructor,
-    NULL
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    Function_gc_traverse
 };
 
 static const builtin_prop_t FunctionInst_props[] = {
@@ -582,7 +624,11 @@ static const builtin_info_t FunctionInst_info = {
     ARRAY_SIZE(FunctionInst_props),
     FunctionInst_props,
     Function_destructor,
-    NULL
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    Function_gc_traverse
 };
 
 static HRESULT create_function(script_ctx_t *ctx, const builtin_info_t *builtin_info, const function_vtbl_t *vtbl, size_t size,
@@ -662,7 +708,8 @@ static const function_vtbl_t NativeFunctionVtbl = {
     NativeFunction_call,
     NativeFunction_toString,
     NativeFunction_get_code,
-    NativeFunction_destructor
+    NativeFunction_destructor,
+    NULL
 };
 
 HRESULT create_builtin_function(script_ctx_t *ctx, builtin_invoke_t value_proc, const WCHAR *name,
@@ -781,11 +828,19 @@ static void InterpretedFunction_destructor(FunctionInstance *func)
         scope_release(function->scope_chain);
 }
 
+static void InterpretedFunction_gc_traverse(struct gc_ctx *gc, FunctionInstance *func)
+{
+    InterpretedFunction *function = (InterpretedFunction*)func;
+
+    gc_visit_scope(gc, function->scope_chain);
+}
+
 static const function_vtbl_t InterpretedFunctionVtbl = {
     InterpretedFunction_call,
     InterpretedFunction_toString,
     InterpretedFunction_get_code,
-    InterpretedFunction_destructor
+    InterpretedFunction_destructor,
+    InterpretedFunction_gc_traverse
 };
 
 HRESULT create_source_function(script_ctx_t *ctx, bytecode_t *code, function_code_t *func_code,
@@ -881,11 +936,24 @@ static void BindFunction_destructor(FunctionInstance *func)
         IDispatch_Release(function->this);
 }
 
+static void BindFunction_gc_traverse(struct gc_ctx *gc, FunctionInstance *func)
+{
+    BindFunction *function = (BindFunction*)func;
+    unsigned i;
+
+    for(i = 0; i < function->argc; i++)
+        gc_visit_val(gc, function->args[i]);
+    gc_visit_obj(gc, &function->target->dispex);
+    if(function->this)
+        gc_visit_obj(gc, to_jsdisp(function->this));
+}
+
 static const function_vtbl_t BindFunctionVtbl = {
     BindFunction_call,
     BindFunction_toString,
     BindFunction_get_code,
-    BindFunction_destructor
+    BindFunction_destructor,
+    BindFunction_gc_traverse
 };
 
 static HRESULT create_bind_function(script_ctx_t *ctx, FunctionInstance *target, IDispatch *bound_this, unsigned argc,
@@ -549,9 +549,11 @@ static HRESULT JSGlobal_ScriptEngineBuildVersion(script_ctx_t *ctx, jsval_t vthi
 static HRESULT JSGlobal_CollectGarbage(script_ctx_t *ctx, jsval_t vthis, WORD flags, unsigned argc, jsval_t *argv,
         jsval_t *r)
 {
-    static int once = 0;
-    if (!once++)
-        FIXME(": stub\n");
+    TRACE("\n");
+
+    gc_run(ctx);
+    if(r)
+        *r = jsval_undefined();
     return S_OK;
 }
 
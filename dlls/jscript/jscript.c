@@ -495,6 +495,7 @@ static void decrease_state(JScript *This, SCRIPTSTATE state)
             }
 
             script_globals_release(This->ctx);
+            gc_run(This->ctx);
             /* FALLTHROUGH */
         case SCRIPTSTATE_UNINITIALIZED:
             change_state(This, state);
@@ -734,6 +735,8 @@ static HRESULT WINAPI JScript_SetScriptSite(IActiveScript *iface,
         ctx->html_mode = This->html_mode;
         ctx->acc = jsval_undefined();
         list_init(&ctx->named_items);
+        list_init(&ctx->objects);
+        ctx->gc_threshold = GC_MIN_THRESHOLD;
         heap_pool_init(&ctx->tmp_heap);
 
         hres = create_jscaller(ctx);
@@ -53,6 +53,7 @@ typedef struct _jsexcept_t jsexcept_t;
 typedef struct _script_ctx_t script_ctx_t;
 typedef struct _dispex_prop_t dispex_prop_t;
 typedef struct _property_desc_t property_desc_t;
+struct gc_ctx;
 
 typedef struct {
     void **blocks;
@@ -176,6 +177,8 @@ typedef struct {
     unsigned (*idx_length)(jsdisp_t*);
     HRESULT (*idx_get)(jsdisp_t*,unsigned,jsval_t*);
     HRESULT (*idx_put)(jsdisp_t*,unsigned,jsval_t);
+    void (*gc_traverse)(struct gc_ctx*,jsdisp_t*);
+    void (*gc_unlink)(jsdisp_t*);
 } builtin_info_t;
 
 struct jsdisp_t {
@@ -192,6 +195,9 @@ struct jsdisp_t {
     jsdisp_t *prototype;
 
     const builtin_info_t *builtin_info;
+
+    struct list entry;
+    LONG gc_ref;
 };
 
 static inline IDispatch *to_disp(jsdisp_t *jsdisp)
@@ -239,6 +245,9 @@ enum jsdisp_enum_type {
 HRESULT create_dispex(script_ctx_t*,const builtin_info_t*,jsdisp_t*,jsdisp_t**) DECLSPEC_HIDDEN;
 HRESULT init_dispex(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*) DECLSPEC_HIDDEN;
 HRESULT init_dispex_from_constr(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*) DECLSPEC_HIDDEN;
+void gc_run(script_ctx_t*) DECLSPEC_HIDDEN;
+void gc_visit_obj(struct gc_ctx*,jsdisp_t*) DECLSPEC_HIDDEN;
+void gc_visit_val(struct gc_ctx*,jsval_t) DECLSPEC_HIDDEN;
 
 HRESULT disp_call(script_ctx_t*,IDispatch*,DISPID,WORD,unsigned,jsval_t*,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT disp_call_name(script_ctx_t*,IDispatch*,const WCHAR*,WORD,unsigned,jsval_t*,jsval_t*) DECLSPEC_HIDDEN;
@@ -256,6 +265,7 @@ HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_id_cached(jsdisp_t*,const WCHAR*,DWORD,unsigned*,DISPID*) DECLSPEC_HIDDEN;
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*) DECLSPEC_HIDDEN;
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD) DECLSPEC_HIDDEN;
@@ -358,6 +368,9 @@ typedef struct {
     unsigned length;
 } match_result_t;
 
+/* Number of live objects that triggers a garbage collection on the next call into script code, see gc_run. */
+#define GC_MIN_THRESHOLD 4096
+
 struct _script_ctx_t {
     LONG ref;
 
@@ -378,6 +391,12 @@ struct _script_ctx_t {
 
     heap_pool_t tmp_heap;
 
+    struct list objects;
+    unsigned object_cnt;
+    unsigned gc_threshold;
+    unsigned gc_gen;
+    BOOL gc_is_running;
+
     jsval_t *stack;
     unsigned stack_top;
     jsval_t acc;
@@ -2532,6 +2532,31 @@ SimpleMatch(REGlobalData *gData, match_state_t *x, REOp op,
     return NULL;
 }
 
+/*
+ * If op matches a literal, case sensitive string, return its first character
+ * so that the input can be scanned for it before trying to match.
+ */
+static BOOL
+GetFirstLiteralChar(regexp_t *re, REOp op, jsbytecode *pc, WCHAR *ch)
+{
+    size_t offset;
+
+    switch (op) {
+      case REOP_FLAT:
+        ReadCompactIndex(pc, &offset);
+        *ch = re->source[offset];
+        return TRUE;
+      case REOP_FLAT1:
+        *ch = *pc;
+        return TRUE;
+      case REOP_UCFLAT1:
+        *ch = GET_ARG(pc);
+        return TRUE;
+      default:
+        return FALSE;
+    }
+}
+
 static inline match_state_t *
 ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
 {
@@ -2548,7 +2573,8 @@ ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
     WCHAR matchCh1, matchCh2;
     RECharSet *charSet;
 
-    BOOL anchor;
+    BOOL anchor, literal;
+    WCHAR firstCh;
     jsbytecode *pc = gData->regexp->program;
     REOp op = (REOp) *pc++;
 
@@ -2558,7 +2584,19 @@ ExecuteREBytecode(REGlobalData *gData, match_state_t *x)
      */
     if (REOP_IS_SIMPLE(op) && !(gData->regexp->flags & REG_STICKY)) {
         anchor = FALSE;
+        literal = GetFirstLiteralChar(gData->regexp, op, pc, &firstCh);
         while (x->cp <= gData->cpend) {
+            if (literal) {
+                /* Skip straight to the next occurrence of the first character. */
+                startcp = wmemchr(x->cp, firstCh, gData->cpend - x->cp);
+                if (!startcp) {
+                    gData->skipped += gData->cpend + 1 - x->cp;
+                    x->cp = gData->cpend + 1;
+                    break;
+                }
+                gData->skipped += startcp - x->cp;
+                x->cp = startcp;
+            }
             nextpc = pc;    /* reset back to start each time */
             result = SimpleMatch(gData, x, op, &nextpc, TRUE);
             if (result) {
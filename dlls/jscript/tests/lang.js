@@ -2065,6 +2065,86 @@ ok(Date === 1, "Date = " + Date);
 Error = 1;
 ok(Error === 1, "Error = " + Error);
 
+/* Member access sites cache property ids, make sure they are revalidated for each object. */
+function testMemberCache() {
+    function get_x(o) { return o.x; }
+    function set_x(o, v) { o.x = v; }
+    var objs = [{x: 1, y: 2}, {y: 3, x: 4}, {z: 5}, {x: 6}], r = [], i;
+
+    for(i = 0; i < objs.length; i++)
+        r.push(get_x(objs[i]));
+    ok(r.join() === "1,4,,6", "r = " + r);
+
+    for(i = 0; i < objs.length; i++)
+        set_x(objs[i], i * 10);
+    r = [];
+    for(i = 0; i < objs.length; i++)
+        r.push(get_x(objs[i]));
+    ok(r.join() === "0,10,20,30", "r = " + r);
+    ok(objs[2].z === 5, "objs[2].z = " + objs[2].z);
+
+    delete objs[0].x;
+    ok(get_x(objs[0]) === undefined, "get_x(objs[0]) = " + get_x(objs[0]));
+    objs[0].x = 7;
+    ok(get_x(objs[0]) === 7, "get_x(objs[0]) = " + get_x(objs[0]));
+
+    function C() {}
+    C.prototype.x = "proto";
+    var c1 = new C(), c2 = new C();
+    ok(get_x(c1) === "proto", "get_x(c1) = " + get_x(c1));
+    c2.x = "own";
+    ok(get_x(c2) === "own", "get_x(c2) = " + get_x(c2));
+    ok(get_x(c1) === "proto", "get_x(c1) = " + get_x(c1));
+    delete C.prototype.x;
+    ok(get_x(c1) === undefined, "get_x(c1) = " + get_x(c1));
+    ok(get_x(c2) === "own", "get_x(c2) = " + get_x(c2));
+}
+testMemberCache();
+
+/* Allocate enough cyclic garbage to trigger collections and make sure live objects survive. */
+function testGC() {
+    var live = {name: "live"}, counter, i, n, o;
+
+    function makeGarbage(i) {
+        var obj = {i: i}, arr = [obj];
+
+        obj.a = arr;
+        obj.self = obj;
+        obj.get = function() { return obj.i; };
+        return obj;
+    }
+
+    live.self = live;
+    live.arr = [live, {v: 1}];
+    live.get = function() { return live.name; };
+    counter = (function() { var n = 0; return function() { return ++n; }; })();
+
+    for(i = 0; i < 20000; i++) {
+        o = makeGarbage(i);
+        if(!(i % 1000)) {
+            live["k" + i] = o;
+            counter();
+        }
+    }
+
+    ok(live.self === live, "live.self !== live");
+    ok(live.arr[0] === live, "live.arr[0] !== live");
+    ok(live.arr[1].v === 1, "live.arr[1].v = " + live.arr[1].v);
+    ok(live.get() === "live", "live.get() = " + live.get());
+    ok(live.k5000.i === 5000, "live.k5000.i = " + live.k5000.i);
+    ok(live.k5000.a[0] === live.k5000, "live.k5000.a[0] !== live.k5000");
+    ok(live.k5000.get() === 5000, "live.k5000.get() = " + live.k5000.get());
+    ok(o.i === 19999 && o.self === o, "o.i = " + o.i);
+    n = counter();
+    ok(n === 21, "counter() = " + n);
+
+    CollectGarbage();
+    ok(live.k19000.get() === 19000, "live.k19000.get() = " + live.k19000.get());
+    n = counter();
+    ok(n === 22, "counter() = " + n);
+}
+testGC();
+
 /* Keep this test in the end of file */
 undefined = 6;
 ok(undefined === 6, "undefined = " + undefined);
@@ -713,4 +713,18 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+/* literal first characters are found by scanning the input */
+m = "xxabxxabcx".match(/abc/);
+ok(m.index === 6, "m.index = " + m.index);
+m = "xxabxxabcx".match(/a[b]c/g);
+ok(m.length === 1 && m[0] === "abc", "m = " + m);
+m = "xxabxxabcx".match(/z/);
+ok(m === null, "m = " + m);
+ok("a\u0100b\u0100c".replace(/\u0100/g, "-") === "a-b-c", "replace(/\\u0100/g) failed");
+ok("xaxbxa".replace(/x/g, "") === "aba", "replace(/x/g) failed");
+re = /b/g;
+ok(re.exec("abab").index === 1, "first exec failed");
+ok(re.exec("abab").index === 3, "second exec failed");
+ok(re.exec("abab") === null, "third exec failed");
+
 reportSuccess();
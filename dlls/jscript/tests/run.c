@@ -3461,6 +3461,19 @@ static void test_destructors(void)
     CHECK_CALLED(testdestrobj);
 
     IActiveScript_Release(script);
+
+    /* a closure referencing its own activation object is freed by CollectGarbage() */
+    V_VT(&v) = VT_EMPTY;
+    SET_EXPECT(testdestrobj);
+    hres = parse_script_expr(L"(function() { var o = testDestrObj, f = function() { return f && o; }; })(),"
+                             L"CollectGarbage(), true", &v, &script);
+    ok(hres == S_OK, "parse_script_expr failed: %08lx\n", hres);
+    ok(V_VT(&v) == VT_BOOL, "V_VT(v) = %d\n", V_VT(&v));
+    CHECK_CALLED(testdestrobj);
+
+    hres = IActiveScript_SetScriptState(script, SCRIPTSTATE_UNINITIALIZED);
+    ok(hres == S_OK, "SetScriptState(SCRIPTSTATE_UNINITIALIZED) failed: %08lx\n", hres);
+    IActiveScript_Release(script);
 }
 
 static void test_eval(void)
@@ -3427,6 +3427,22 @@ static NTSTATUS find_query_actctx( HANDLE *handle, DWORD flags, ULONG class )
     return status;
 }
 
+static int __cdecl string_index_cmp(const void *p1, const void *p2)
+{
+    const struct string_index *index1 = p1, *index2 = p2;
+
+    if (index1->hash != index2->hash) return index1->hash < index2->hash ? -1 : 1;
+    /* data is laid out in manifest order, keep entries with the same hash in that order */
+    if (index1->data_offset != index2->data_offset) return index1->data_offset < index2->data_offset ? -1 : 1;
+    return 0;
+}
+
+/* sort the index by hash so that lookups can use a binary search */
+static void sort_string_index(struct strsection_header *section)
+{
+    qsort((BYTE*)section + section->index_offset, section->count, sizeof(struct string_index), string_index_cmp);
+}
+
 static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct strsection_header **section)
 {
     unsigned int i, j, total_len = 0, dll_count = 0;
@@ -3528,6 +3544,7 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
         }
     }
 
+    sort_string_index(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3537,26 +3554,30 @@ static struct string_index *find_string_index(const struct strsection_header *se
 {
     struct string_index *iter, *index = NULL;
     UNICODE_STRING str;
-    ULONG hash = 0, i;
+    ULONG hash = 0, min = 0, max = section->count, pos;
 
     RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
     iter = (struct string_index*)((BYTE*)section + section->index_offset);
 
-    for (i = 0; i < section->count; i++)
+    /* the index is sorted by hash, find the first entry with a matching one */
+    while (min < max)
+    {
+        pos = (min + max) / 2;
+        if (iter[pos].hash < hash) min = pos + 1;
+        else max = pos;
+    }
+
+    for (iter += min; min < section->count && iter->hash == hash; min++, iter++)
     {
-        if (iter->hash == hash)
+        str.Buffer = (WCHAR *)((BYTE *)section + iter->name_offset);
+        str.Length = iter->name_len;
+        if (RtlEqualUnicodeString( &str, name, TRUE ))
         {
-            str.Buffer = (WCHAR *)((BYTE *)section + iter->name_offset);
-            str.Length = iter->name_len;
-            if (RtlEqualUnicodeString( &str, name, TRUE ))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
+            index = iter;
+            break;
         }
-        iter++;
+        else
+            WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
     }
 
     return index;
@@ -3629,11 +3650,6 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_wndclass_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index*)((BYTE*)actctx->wndclass_section + actctx->wndclass_section->index_offset);
-}
-
 static inline struct wndclass_redirect_data *get_wndclass_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct wndclass_redirect_data*)((BYTE*)ctxt->wndclass_section + index->data_offset);
@@ -3771,6 +3787,7 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
         }
     }
 
+    sort_string_index(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3779,11 +3796,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
 static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                   PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
+    struct string_index *index;
     struct wndclass_redirect_data *class;
-    UNICODE_STRING str;
-    ULONG hash;
-    int i;
 
     if (!(actctx->sections & WINDOWCLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3798,27 +3812,7 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_wndclass_first_index(actctx);
-
-    for (i = 0; i < actctx->wndclass_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            str.Buffer = (WCHAR *)((BYTE *)actctx->wndclass_section + iter->name_offset);
-            str.Length = iter->name_len;
-            if (RtlEqualUnicodeString( &str, name, TRUE ))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->wndclass_section, name);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     if (data)
@@ -3842,11 +3836,6 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_activatable_class_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index *)((BYTE *)actctx->activatable_class_section + actctx->activatable_class_section->index_offset);
-}
-
 static inline struct activatable_class_data *get_activatable_class_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct activatable_class_data *)((BYTE *)ctxt->activatable_class_section + index->data_offset);
@@ -3971,6 +3960,7 @@ static NTSTATUS build_activatable_class_section(ACTIVATION_CONTEXT *actctx, stru
         }
     }
 
+    sort_string_index(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3979,11 +3969,8 @@ static NTSTATUS build_activatable_class_section(ACTIVATION_CONTEXT *actctx, stru
 static NTSTATUS find_activatable_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                        PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
+    struct string_index *index;
     struct activatable_class_data *class;
-    UNICODE_STRING str;
-    ULONG hash;
-    int i;
 
     if (!(actctx->sections & ACTIVATABLE_CLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3998,27 +3985,7 @@ static NTSTATUS find_activatable_class(ACTIVATION_CONTEXT* actctx, const UNICODE
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_activatable_class_first_index(actctx);
-
-    for (i = 0; i < actctx->activatable_class_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            str.Buffer = (WCHAR *)((BYTE *)actctx->activatable_class_section + iter->name_offset);
-            str.Length = iter->name_len;
-            if (RtlEqualUnicodeString( &str, name, TRUE ))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->activatable_class_section, name);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     if (data)
@@ -5034,6 +5001,7 @@ static NTSTATUS build_progid_section(ACTIVATION_CONTEXT* actctx, struct strsecti
         }
     }
 
+    sort_string_index(header);
     *section = header;
 
     return STATUS_SUCCESS;
@@ -20,6 +20,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -29,6 +30,7 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "ntdll_misc.h"
 #include "wine/debug.h"
 
@@ -61,12 +63,16 @@ struct relay_entry_point
 {
     void       *orig_func;    /* original entry point function */
     const char *name;         /* function name (if any) */
+    LONG        calls;        /* number of calls, in counting and sampling modes */
+    LONGLONG    time;         /* total time spent in the function, in counting mode */
 };
 
 struct relay_private_data
 {
+    struct list              entry;             /* entry in the list of relayed dlls */
     HMODULE                  module;            /* module handle of this dll */
     unsigned int             base;              /* ordinal base */
+    unsigned int             nb_entry_points;   /* number of entry points */
     char                     dllname[40];       /* dll name (without .dll extension) */
     struct relay_entry_point entry_points[1];   /* list of dll entry points */
 };
@@ -80,6 +86,10 @@ static const WCHAR **debug_from_relay_includelist;
 static const WCHAR **debug_from_snoop_excludelist;
 static const WCHAR **debug_from_snoop_includelist;
 
+static BOOL relay_count_calls;        /* count calls instead of tracing them */
+static DWORD relay_sample_rate;       /* only trace one call out of this many */
+static struct list relay_dlls = LIST_INIT( relay_dlls );
+
 static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
 
 /* compare an ASCII and a Unicode string without depending on the current codepage */
@@ -157,6 +167,32 @@ static const WCHAR **load_list( HKEY hkey, const WCHAR *value )
     return list;
 }
 
+/***********************************************************************
+ *           load_dword
+ *
+ * Load a numeric value from the registry, stored either as a DWORD or as a string.
+ */
+static DWORD load_dword( HKEY hkey, const WCHAR *value )
+{
+    char buffer[offsetof( KEY_VALUE_PARTIAL_INFORMATION, Data[64] )];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    UNICODE_STRING name;
+    DWORD count, ret = 0;
+
+    RtlInitUnicodeString( &name, value );
+    if (NtQueryValueKey( hkey, &name, KeyValuePartialInformation, buffer, sizeof(buffer) - sizeof(WCHAR), &count ))
+        return 0;
+    if (info->Type == REG_DWORD && info->DataLength == sizeof(DWORD))
+        memcpy( &ret, info->Data, sizeof(ret) );
+    else if (info->Type == REG_SZ)
+    {
+        ((WCHAR *)info->Data)[info->DataLength / sizeof(WCHAR)] = 0;
+        ret = wcstoul( (WCHAR *)info->Data, NULL, 0 );
+    }
+    TRACE( "%s = %u\n", debugstr_w(value), ret );
+    return ret;
+}
+
 /***********************************************************************
  *           init_debug_lists
  *
@@ -190,6 +226,8 @@ static DWORD WINAPI init_debug_lists( RTL_RUN_ONCE *once, void *param, void **co
     debug_from_relay_excludelist = load_list( hkey, L"RelayFromExclude" );
     debug_from_snoop_includelist = load_list( hkey, L"SnoopFromInclude" );
     debug_from_snoop_excludelist = load_list( hkey, L"SnoopFromExclude" );
+    relay_count_calls = load_dword( hkey, L"RelayCount" ) != 0;
+    relay_sample_rate = load_dword( hkey, L"RelaySample" );
 
     NtClose( hkey );
     return TRUE;
@@ -303,6 +341,111 @@ static void trace_string_w( INT_PTR ptr )
     else TRACE( "%08Ix", ptr );
 }
 
+struct relay_frame
+{
+    struct relay_entry_point *entry_point;
+    LONGLONG                  start;
+    BOOL                      traced;
+};
+
+struct relay_thread_data
+{
+    unsigned int       depth;
+    struct relay_frame frames[128];
+};
+
+/* calls are matched with their return through a per-thread stack, stored in
+ * a TEB field that is otherwise unused so that no application TLS slot is taken */
+static struct relay_thread_data *get_relay_thread_data(void)
+{
+    struct relay_thread_data *data;
+
+    if (!(data = NtCurrentTeb()->Instrumentation[0]))
+    {
+        data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data) );
+        NtCurrentTeb()->Instrumentation[0] = data;
+    }
+    return data;
+}
+
+/***********************************************************************
+ *           relay_enter
+ *
+ * Account for a call to a relayed function, and check whether its arguments should be traced.
+ */
+static BOOL relay_enter( struct relay_entry_point *entry_point )
+{
+    struct relay_thread_data *thread;
+    struct relay_frame *frame;
+    LARGE_INTEGER now;
+    LONG count;
+    BOOL traced;
+
+    if (!relay_count_calls && relay_sample_rate <= 1) return TRUE;
+
+    count = InterlockedIncrement( &entry_point->calls );
+    traced = relay_sample_rate && !((count - 1) % relay_sample_rate);
+
+    if (!(thread = get_relay_thread_data())) return traced;
+    if (thread->depth < ARRAY_SIZE(thread->frames))
+    {
+        frame = &thread->frames[thread->depth];
+        frame->entry_point = entry_point;
+        frame->traced = traced;
+        if (relay_count_calls)
+        {
+            NtQueryPerformanceCounter( &now, NULL );
+            frame->start = now.QuadPart;
+        }
+    }
+    thread->depth++;
+    return traced;
+}
+
+/***********************************************************************
+ *           relay_leave
+ *
+ * Account for the return from a relayed function, and check whether it should be traced.
+ */
+static BOOL relay_leave( struct relay_entry_point *entry_point )
+{
+    struct relay_thread_data *thread;
+    struct relay_frame *frame;
+    LARGE_INTEGER now;
+    unsigned int depth;
+
+    if (!relay_count_calls && relay_sample_rate <= 1) return TRUE;
+
+    if (!(thread = get_relay_thread_data()) || !thread->depth) return FALSE;
+    if (thread->depth > ARRAY_SIZE(thread->frames))
+    {
+        thread->depth--;
+        return FALSE;
+    }
+
+    /* frames above the matching one have been unwound by an exception */
+    for (depth = thread->depth; depth > 0; depth--)
+    {
+        frame = &thread->frames[depth - 1];
+        if (frame->entry_point != entry_point) continue;
+        thread->depth = depth - 1;
+        if (relay_count_calls)
+        {
+            NtQueryPerformanceCounter( &now, NULL );
+            InterlockedExchangeAdd64( &entry_point->time, now.QuadPart - frame->start );
+        }
+        return frame->traced;
+    }
+    return FALSE;
+}
+
+static struct relay_entry_point *get_entry_point( struct relay_descr *descr, unsigned int idx )
+{
+    struct relay_private_data *data = descr->private;
+
+    return data->entry_points + LOWORD(idx);
+}
+
 #ifdef __i386__
 
 /***********************************************************************
@@ -316,40 +459,45 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i, pos;
+    BOOL trace = relay_enter( entry_point );
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = pos = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 'j': /* int64 */
-            TRACE( "%x%08x", stack[pos+1], stack[pos] );
+            if (trace) TRACE( "%x%08x", stack[pos+1], stack[pos] );
             pos += 2;
             break;
         case 'k': /* int128 */
-            TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
+            if (trace) TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
             pos += 4;
             break;
         case 's': /* str */
-            trace_string_a( stack[pos++] );
+            if (trace) trace_string_a( stack[pos] );
+            pos++;
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[pos++] );
+            if (trace) trace_string_w( stack[pos] );
+            pos++;
             break;
         case 'f': /* float */
-            TRACE( "%g", *(const float *)&stack[pos++] );
+            if (trace) TRACE( "%g", *(const float *)&stack[pos] );
+            pos++;
             break;
         case 'd': /* double */
-            TRACE( "%g", *(const double *)&stack[pos] );
+            if (trace) TRACE( "%g", *(const double *)&stack[pos] );
             pos += 2;
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08x", stack[pos++] );
+            if (trace) TRACE( "%08x", stack[pos] );
+            pos++;
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
     *nb_args = pos;
     if (arg_types[0] == 't')
@@ -357,7 +505,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         *nb_args |= 0x80000000;  /* thiscall/fastcall */
         if (arg_types[1] == 't') *nb_args |= 0x40000000;  /* fastcall */
     }
-    TRACE( ") ret=%08x\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08x\n", stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -369,6 +517,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (!relay_leave( get_entry_point( descr, idx ))) return;
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -459,8 +609,9 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     unsigned int float_pos = 0, double_pos = 0;
     const union fpregs { float s[16]; double d[8]; } *fpstack = (const union fpregs *)stack - 1;
 #endif
+    BOOL trace = relay_enter( entry_point );
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = pos = 0; !is_ret_val( arg_types[i] ); i++)
     {
@@ -468,49 +619,55 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         {
         case 'j': /* int64 */
             pos = (pos + 1) & ~1;
-            TRACE( "%x%08x", stack[pos+1], stack[pos] );
+            if (trace) TRACE( "%x%08x", stack[pos+1], stack[pos] );
             pos += 2;
             break;
         case 'k': /* int128 */
-            TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
+            if (trace) TRACE( "{%08x,%08x,%08x,%08x}", stack[pos], stack[pos+1], stack[pos+2], stack[pos+3] );
             pos += 4;
             break;
         case 's': /* str */
-            trace_string_a( stack[pos++] );
+            if (trace) trace_string_a( stack[pos] );
+            pos++;
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[pos++] );
+            if (trace) trace_string_w( stack[pos] );
+            pos++;
             break;
         case 'f': /* float */
 #ifndef __SOFTFP__
             if (!(float_pos % 2)) float_pos = max( float_pos, double_pos * 2 );
             if (float_pos < 16)
             {
-                TRACE( "%g", fpstack->s[float_pos++] );
+                if (trace) TRACE( "%g", fpstack->s[float_pos] );
+                float_pos++;
                 break;
             }
 #endif
-            TRACE( "%g", *(const float *)&stack[pos++] );
+            if (trace) TRACE( "%g", *(const float *)&stack[pos] );
+            pos++;
             break;
         case 'd': /* double */
 #ifndef __SOFTFP__
             double_pos = max( (float_pos + 1) / 2, double_pos );
             if (double_pos < 8)
             {
-                TRACE( "%g", fpstack->d[double_pos++] );
+                if (trace) TRACE( "%g", fpstack->d[double_pos] );
+                double_pos++;
                 break;
             }
 #endif
             pos = (pos + 1) & ~1;
-            TRACE( "%g", *(const double *)&stack[pos] );
+            if (trace) TRACE( "%g", *(const double *)&stack[pos] );
             pos += 2;
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08x", stack[pos++] );
+            if (trace) TRACE( "%08x", stack[pos] );
+            pos++;
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
 
 #ifndef __SOFTFP__
@@ -521,7 +678,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
 #endif
     *nb_args = pos;
-    TRACE( ") ret=%08x\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08x\n", stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -533,6 +690,8 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (!relay_leave( get_entry_point( descr, idx ))) return;
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -609,28 +768,29 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i;
+    BOOL trace = relay_enter( entry_point );
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 's': /* str */
-            trace_string_a( stack[i] );
+            if (trace) trace_string_a( stack[i] );
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[i] );
+            if (trace) trace_string_w( stack[i] );
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08zx", stack[i] );
+            if (trace) TRACE( "%08zx", stack[i] );
             break;
         }
-        if (!is_ret_val( arg_types[i + 1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i + 1] )) TRACE( "," );
     }
     *nb_args = i;
-    TRACE( ") ret=%08zx\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08zx\n", stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -640,6 +800,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (!relay_leave( get_entry_point( descr, idx ))) return;
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -709,34 +871,35 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
     unsigned int i;
+    BOOL trace = relay_enter( entry_point );
 
-    TRACE( "\1Call %s(", func_name( data, ordinal ));
+    if (trace) TRACE( "\1Call %s(", func_name( data, ordinal ));
 
     for (i = 0; !is_ret_val( arg_types[i] ); i++)
     {
         switch (arg_types[i])
         {
         case 's': /* str */
-            trace_string_a( stack[i] );
+            if (trace) trace_string_a( stack[i] );
             break;
         case 'w': /* wstr */
-            trace_string_w( stack[i] );
+            if (trace) trace_string_w( stack[i] );
             break;
         case 'f': /* float */
-            TRACE( "%g", *(const float *)&stack[i] );
+            if (trace) TRACE( "%g", *(const float *)&stack[i] );
             break;
         case 'd': /* double */
-            TRACE( "%g", *(const double *)&stack[i] );
+            if (trace) TRACE( "%g", *(const double *)&stack[i] );
             break;
         case 'i': /* long */
         default:
-            TRACE( "%08zx", stack[i] );
+            if (trace) TRACE( "%08zx", stack[i] );
             break;
         }
-        if (!is_ret_val( arg_types[i+1] )) TRACE( "," );
+        if (trace && !is_ret_val( arg_types[i+1] )) TRACE( "," );
     }
     *nb_args = i;
-    TRACE( ") ret=%08zx\n", stack[-1] );
+    if (trace) TRACE( ") ret=%08zx\n", stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -746,6 +909,8 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (!relay_leave( get_entry_point( descr, idx ))) return;
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -892,9 +1057,11 @@ void RELAY_SetupDLL( HMODULE module )
 
     descr->relay_call = relay_call;
     descr->private = data;
+    list_add_tail( &relay_dlls, &data->entry );
 
     data->module = module;
     data->base   = exports->Base;
+    data->nb_entry_points = exports->NumberOfFunctions;
     len = strlen( (char *)module + exports->Name );
     if (len > 4 && !_stricmp( (char *)module + exports->Name + len - 4, ".dll" )) len -= 4;
     len = min( len, sizeof(data->dllname) - 1 );
@@ -932,6 +1099,129 @@ void RELAY_SetupDLL( HMODULE module )
         NtProtectVirtualMemory( NtCurrentProcess(), &func_base, &func_size, old_prot, &old_prot );
 }
 
+/***********************************************************************
+ *           RELAY_FreeDLL
+ *
+ * Release the relay data of a dll that is being unloaded.
+ */
+void RELAY_FreeDLL( HMODULE module )
+{
+    struct relay_private_data *data;
+    unsigned int i;
+    char *name;
+
+    LIST_FOR_EACH_ENTRY( data, &relay_dlls, struct relay_private_data, entry )
+    {
+        if (data->module != module) continue;
+
+        data->module = NULL;
+        if (relay_count_calls || relay_sample_rate > 1)
+        {
+            /* keep the counts for the final report, but the names point into the image */
+            for (i = 0; i < data->nb_entry_points; i++)
+            {
+                if (!data->entry_points[i].name) continue;
+                if (data->entry_points[i].calls &&
+                    (name = RtlAllocateHeap( GetProcessHeap(), 0, strlen( data->entry_points[i].name ) + 1 )))
+                    data->entry_points[i].name = strcpy( name, data->entry_points[i].name );
+                else
+                    data->entry_points[i].name = NULL;
+            }
+        }
+        else
+        {
+            list_remove( &data->entry );
+            RtlFreeHeap( GetProcessHeap(), 0, data );
+        }
+        return;
+    }
+}
+
+/***********************************************************************
+ *           RELAY_FreeThreadData
+ *
+ * Free the per-thread call stack when a thread exits.
+ */
+void RELAY_FreeThreadData(void)
+{
+    RtlFreeHeap( GetProcessHeap(), 0, NtCurrentTeb()->Instrumentation[0] );
+    NtCurrentTeb()->Instrumentation[0] = NULL;
+}
+
+struct relay_call_count
+{
+    struct relay_private_data *data;
+    unsigned int               ordinal;
+    LONG                       calls;
+};
+
+static int __cdecl compare_calls( const void *p1, const void *p2 )
+{
+    const struct relay_call_count *c1 = p1, *c2 = p2;
+
+    if (c1->calls != c2->calls) return c1->calls < c2->calls ? 1 : -1;
+    return 0;
+}
+
+/***********************************************************************
+ *           RELAY_PrintCallCounts
+ *
+ * Print the call counts gathered in counting and sampling modes, most called functions first.
+ */
+void RELAY_PrintCallCounts(void)
+{
+    struct relay_private_data *data;
+    struct relay_call_count *counts = NULL;
+    unsigned int i, count = 0, size = 0;
+    LARGE_INTEGER now, freq;
+
+    if (!relay_count_calls && relay_sample_rate <= 1) return;
+    NtQueryPerformanceCounter( &now, &freq );
+
+    LIST_FOR_EACH_ENTRY( data, &relay_dlls, struct relay_private_data, entry )
+    {
+        for (i = 0; i < data->nb_entry_points; i++)
+        {
+            if (!data->entry_points[i].calls) continue;
+            if (count == size)
+            {
+                struct relay_call_count *new_counts;
+
+                size = max( size * 2, 256 );
+                if (counts) new_counts = RtlReAllocateHeap( GetProcessHeap(), 0, counts, size * sizeof(*counts) );
+                else new_counts = RtlAllocateHeap( GetProcessHeap(), 0, size * sizeof(*counts) );
+                if (!new_counts) goto done;
+                counts = new_counts;
+            }
+            counts[count].data = data;
+            counts[count].ordinal = i;
+            counts[count].calls = data->entry_points[i].calls;
+            count++;
+        }
+    }
+    qsort( counts, count, sizeof(*counts), compare_calls );
+
+    TRACE( "%u functions called\n", count );
+    for (i = 0; i < count; i++)
+    {
+        struct relay_entry_point *entry_point = &counts[i].data->entry_points[counts[i].ordinal];
+
+        if (relay_count_calls)
+        {
+            /* the time is in performance counter ticks, split the division to avoid overflows */
+            LONGLONG us = entry_point->time / freq.QuadPart * 1000000 +
+                          entry_point->time % freq.QuadPart * 1000000 / freq.QuadPart;
+            TRACE( "%10u calls %12s us  %s\n", (UINT)counts[i].calls, wine_dbgstr_longlong( us ),
+                   func_name( counts[i].data, counts[i].ordinal ));
+        }
+        else
+            TRACE( "%10u calls  %s\n", (UINT)counts[i].calls, func_name( counts[i].data, counts[i].ordinal ));
+    }
+
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, counts );
+}
+
 #else  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 FARPROC RELAY_GetProcAddress( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -944,6 +1234,18 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+void RELAY_FreeDLL( HMODULE module )
+{
+}
+
+void RELAY_FreeThreadData(void)
+{
+}
+
+void RELAY_PrintCallCounts(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 
@@ -25,13 +25,23 @@
 #include "config.h"
 
 #include <assert.h>
+#include <dlfcn.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#include <sys/time.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -65,6 +75,31 @@ static struct __wine_debug_channel *debug_options;
 
 static const char * const debug_classes[] = { "fixme", "err", "warn", "trace" };
 
+static int debug_fd = 2;
+
+/* Asynchronous output: lines are copied into a ring buffer without taking any lock,
+ * and a background thread writes them out. The buffer size must be a power of 2. */
+
+#define ASYNC_BUFFER_SIZE (4 * 1024 * 1024)
+#define ASYNC_STALL_TIMEOUT 1000000  /* usecs before giving up on an unpublished record */
+
+/* state of a record that isn't published yet, stored in the low bits of its position */
+#define ASYNC_CLAIMED 1  /* the owner is copying the data */
+#define ASYNC_SKIPPED 2  /* the writer gave up waiting before the owner claimed the record */
+#define ASYNC_DROPPED 3  /* the owner saw it was skipped and won't touch the record anymore */
+
+struct async_record
+{
+    unsigned int pos;   /* position of the record in the ring, set once the data is complete */
+    unsigned int len;   /* length of the data following the record, ~0u for padding */
+    unsigned int tid;   /* unix tid of the owner, set before the record is claimed */
+};
+
+static char *async_buffer;
+static unsigned int async_head;  /* next position to reserve */
+static unsigned int async_tail;  /* next position to write out */
+static BOOL async_started;
+
 /* get the debug info pointer for the current thread */
 static inline struct debug_info *get_info(void)
 {
@@ -83,6 +118,7 @@ static int append_output( struct debug_info *info, const char *str, size_t len )
     {
        fprintf( stderr, "wine_dbg_output: debugstr buffer overflow (contents: '%s')\n", info->output );
        info->out_pos = 0;
+       dbg_flush();
        abort();
     }
     memcpy( info->output + info->out_pos, str, len );
@@ -185,7 +221,9 @@ static void debug_usage(void)
         "  WINEDEBUG=[class]+xxx,[class]-yyy,...\n\n"
         "Example: WINEDEBUG=+relay,warn-heap\n"
         "    turns on relay traces, disable heap warnings\n"
-        "Available message classes: err, warn, fixme, trace\n";
+        "Available message classes: err, warn, fixme, trace\n\n"
+        "WINEDEBUGLOG=file sends the output to a file instead of stderr\n"
+        "WINEDEBUGASYNC=1 writes the output from a background thread\n";
     write( 2, usage, sizeof(usage) - 1 );
     exit(1);
 }
@@ -194,12 +232,23 @@ static void debug_usage(void)
 static void init_options(void)
 {
     char *wine_debug = getenv("WINEDEBUG");
+    const char *str;
     struct stat st1, st2;
+    int fd;
 
     nb_debug_options = 0;
 
+    if ((str = getenv("WINEDEBUGLOG")) && str[0])
+    {
+        if ((fd = open( str, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666 )) != -1) debug_fd = fd;
+        else fprintf( stderr, "wine: failed to open debug log %s\n", str );
+    }
+    /* unused space is filled with 0xff, positions are multiples of 8 so they never match ~0u */
+    if ((str = getenv("WINEDEBUGASYNC")) && atoi( str ) && (async_buffer = malloc( ASYNC_BUFFER_SIZE )))
+        memset( async_buffer, 0xff, ASYNC_BUFFER_SIZE );
+
     /* check for stderr pointing to /dev/null */
-    if (!fstat( 2, &st1 ) && S_ISCHR(st1.st_mode) &&
+    if (debug_fd == 2 && !fstat( 2, &st1 ) && S_ISCHR(st1.st_mode) &&
         !stat( "/dev/null", &st2 ) && S_ISCHR(st2.st_mode) &&
         st1.st_rdev == st2.st_rdev)
     {
@@ -252,12 +301,206 @@ const char * __cdecl __wine_dbg_strdup( const char *str )
     return memcpy( info->strings + pos, str, n );
 }
 
+/* reserve space for a record in the ring buffer, returns NULL if it's full */
+static struct async_record *async_reserve( unsigned int len, unsigned int *pos )
+{
+    unsigned int head, tail, offset, pad, size = (sizeof(struct async_record) + len + 7) & ~7;
+    struct async_record *record;
+
+    do
+    {
+        head = __atomic_load_n( &async_head, __ATOMIC_SEQ_CST );
+        tail = __atomic_load_n( &async_tail, __ATOMIC_SEQ_CST );
+        offset = head % ASYNC_BUFFER_SIZE;
+        /* records don't wrap around, pad up to the end of the buffer instead */
+        pad = offset + size > ASYNC_BUFFER_SIZE ? ASYNC_BUFFER_SIZE - offset : 0;
+        if (head + pad + size - tail > ASYNC_BUFFER_SIZE) return NULL;
+    } while (!__atomic_compare_exchange_n( &async_head, &head, head + pad + size, FALSE,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ));
+    if (pad)
+    {
+        record = (struct async_record *)(async_buffer + offset);
+        record->len = ~0u;
+        __atomic_store_n( &record->pos, head, __ATOMIC_RELEASE );
+        head += pad;
+    }
+    *pos = head;
+    return (struct async_record *)(async_buffer + head % ASYNC_BUFFER_SIZE);
+}
+
+static unsigned int async_get_tid(void)
+{
+#ifdef linux
+    return syscall( __NR_gettid );
+#else
+    return 0;
+#endif
+}
+
+/* check whether the owner of a record may still be running */
+static BOOL async_owner_alive( unsigned int tid )
+{
+#ifdef linux
+    return syscall( __NR_tgkill, getpid(), tid, 0 ) != -1 || errno != ESRCH;
+#else
+    return TRUE;
+#endif
+}
+
+/* queue output for the writer thread; this can be called from signal handlers */
+static BOOL async_write( const char *str, unsigned int len )
+{
+    struct async_record *record;
+    unsigned int pos, state = ~0u;
+
+    /* if the writer can't keep up, fall back to a direct write */
+    if (!(record = async_reserve( len, &pos ))) return FALSE;
+    record->tid = async_get_tid();
+    record->len = len;
+    if (!__atomic_compare_exchange_n( &record->pos, &state, pos | ASYNC_CLAIMED, FALSE,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED ))
+    {
+        /* we were suspended for too long and the record was skipped, write directly instead */
+        __atomic_store_n( &record->pos, pos | ASYNC_DROPPED, __ATOMIC_RELEASE );
+        return FALSE;
+    }
+    memcpy( record + 1, str, len );
+    __atomic_store_n( &record->pos, pos, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+/* size of the record at pos, or 0 if its length is not valid */
+static unsigned int async_record_size( unsigned int pos, unsigned int head, unsigned int len )
+{
+    unsigned int size = (sizeof(struct async_record) + len + 7) & ~7;
+
+    if (len >= ASYNC_BUFFER_SIZE) return 0;
+    if (size > ASYNC_BUFFER_SIZE - pos % ASYNC_BUFFER_SIZE || size > head - pos) return 0;
+    return size;
+}
+
+/* give up on a record that wasn't published in time; its space is only reclaimed once its
+ * owner is known to be dead, otherwise an unclaimed record is marked so that its owner
+ * drops it when it resumes. Returns the position of the next record, or pos to keep waiting. */
+static unsigned int async_skip_record( unsigned int pos, unsigned int head )
+{
+    struct async_record *record = (struct async_record *)(async_buffer + pos % ASYNC_BUFFER_SIZE);
+    unsigned int size, state = ~0u;
+
+    if (__atomic_compare_exchange_n( &record->pos, &state, pos | ASYNC_SKIPPED, FALSE,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE ))
+        return pos;
+    if (state != (pos | ASYNC_CLAIMED) || async_owner_alive( record->tid )) return pos;
+    if (!(size = async_record_size( pos, head, record->len ))) return pos;
+    return pos + size;
+}
+
+/* clear the space of the records that have been written out, and release it */
+static void async_release( unsigned int tail, unsigned int next )
+{
+    unsigned int offset = tail % ASYNC_BUFFER_SIZE, len = next - tail;
+
+    if (offset + len > ASYNC_BUFFER_SIZE)
+    {
+        memset( async_buffer + offset, 0xff, ASYNC_BUFFER_SIZE - offset );
+        len -= ASYNC_BUFFER_SIZE - offset;
+        offset = 0;
+    }
+    memset( async_buffer + offset, 0xff, len );
+    __atomic_store_n( &async_tail, next, __ATOMIC_RELEASE );
+}
+
+static void *async_writer( void *arg )
+{
+    struct iovec iov[64];
+    struct async_record *record;
+    unsigned int tail = async_tail, head, next, state, len, size, count, idle = 1000, stalled = 0;
+
+    for (;;)
+    {
+        head = __atomic_load_n( &async_head, __ATOMIC_ACQUIRE );
+        for (count = 0, next = tail; count < ARRAY_SIZE(iov) && next != head; )
+        {
+            record = (struct async_record *)(async_buffer + next % ASYNC_BUFFER_SIZE);
+            state = __atomic_load_n( &record->pos, __ATOMIC_ACQUIRE );
+            if (state != next && state != (next | ASYNC_DROPPED)) break;
+            len = record->len;
+            if (state == next && len == ~0u)
+            {
+                next += ASYNC_BUFFER_SIZE - next % ASYNC_BUFFER_SIZE;
+                continue;
+            }
+            if (!(size = async_record_size( next, head, len ))) break;
+            if (state == next)
+            {
+                iov[count].iov_base = record + 1;
+                iov[count].iov_len = len;
+                count++;
+            }
+            next += size;
+        }
+        if (count) writev( debug_fd, iov, count );
+        if (next == tail && tail != head && (stalled += idle) >= ASYNC_STALL_TIMEOUT)
+        {
+            next = async_skip_record( tail, head );
+            stalled = 0;
+        }
+        if (next == tail)
+        {
+            if (tail == head) stalled = 0;
+            usleep( idle );
+            idle = min( idle * 2, 50000 );
+            continue;
+        }
+        async_release( tail, next );
+        tail = next;
+        idle = 1000;
+        stalled = 0;
+    }
+    return NULL;
+}
+
+static void start_async_writer(void)
+{
+    pthread_t thread;
+    sigset_t set, old_set;
+
+    /* the writer thread has no TEB, so it must never run signal handlers */
+    sigfillset( &set );
+    pthread_sigmask( SIG_BLOCK, &set, &old_set );
+    if (!pthread_create( &thread, NULL, async_writer, NULL ))
+    {
+        pthread_detach( thread );
+        async_started = TRUE;
+    }
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+}
+
+/***********************************************************************
+ *		dbg_flush
+ *
+ * Wait for the asynchronous output to be written out, before exiting.
+ */
+void dbg_flush(void)
+{
+    int i;
+
+    if (!async_started) return;
+    for (i = 0; i < 1000; i++)
+    {
+        if (__atomic_load_n( &async_tail, __ATOMIC_ACQUIRE ) == __atomic_load_n( &async_head, __ATOMIC_ACQUIRE ))
+            break;
+        usleep( 1000 );
+    }
+}
+
 /***********************************************************************
  *		__wine_dbg_write  (NTDLL.@)
  */
 int WINAPI __wine_dbg_write( const char *str, unsigned int len )
 {
-    return write( 2, str, len );
+    if (async_started && async_write( str, len )) return len;
+    return write( debug_fd, str, len );
 }
 
 /***********************************************************************
@@ -330,6 +573,189 @@ void dbg_init(void)
     debug_options = options;
     options[nb_debug_options] = default_option;
     init_done = TRUE;
+
+    if (async_buffer) start_async_writer();
+}
+
+
+/* Sampling profiler: the interrupted instruction pointer is recorded on every SIGPROF,
+ * and the samples are written out as folded stacks when the process exits. */
+
+#define PROFILE_TABLE_SIZE  65536  /* must be a power of 2 */
+#define PROFILE_MAX_PROBES  64
+#define PROFILE_FREQUENCY   1000
+
+struct profile_entry
+{
+    ULONG_PTR pc;
+    LONG      count;
+};
+
+static struct profile_entry *profile_table;
+static LONG profile_lost;
+static char *profile_file;
+
+/***********************************************************************
+ *		profile_init
+ *
+ * Check whether the profiler is enabled through WINEPROFILE=file.
+ */
+BOOL profile_init(void)
+{
+    const char *name = getenv( "WINEPROFILE" );
+    void *table;
+
+    if (!name || !name[0]) return FALSE;
+    /* child processes inherit the variable, so each one writes its own file */
+    if (!(profile_file = malloc( strlen( name ) + 12 ))) return FALSE;
+    sprintf( profile_file, "%s.%u", name, getpid() );
+    table = mmap( NULL, PROFILE_TABLE_SIZE * sizeof(*profile_table), PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if (table == MAP_FAILED)
+    {
+        free( profile_file );
+        profile_file = NULL;
+        return FALSE;
+    }
+    profile_table = table;
+    return TRUE;
+}
+
+/***********************************************************************
+ *		profile_start
+ */
+void profile_start(void)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / PROFILE_FREQUENCY;
+    timer.it_value = timer.it_interval;
+    if (setitimer( ITIMER_PROF, &timer, NULL ) == -1) perror( "wine: setitimer" );
+}
+
+/***********************************************************************
+ *		profile_add_sample
+ *
+ * Count a sample; called from the SIGPROF handler.
+ */
+void profile_add_sample( ULONG_PTR pc )
+{
+    unsigned int i, hash = (unsigned int)(pc >> 2) * 2654435761u;
+    struct profile_entry *entry;
+    ULONG_PTR key;
+
+    for (i = 0; i < PROFILE_MAX_PROBES; i++)
+    {
+        entry = &profile_table[(hash + i) & (PROFILE_TABLE_SIZE - 1)];
+        key = __atomic_load_n( &entry->pc, __ATOMIC_ACQUIRE );
+        if (!key && !__atomic_compare_exchange_n( &entry->pc, &key, pc, FALSE,
+                                                  __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST ))
+        {
+            if (key != pc) continue;  /* taken by another address in the meantime */
+        }
+        else if (key && key != pc) continue;
+        __atomic_add_fetch( &entry->count, 1, __ATOMIC_RELAXED );
+        return;
+    }
+    __atomic_add_fetch( &profile_lost, 1, __ATOMIC_RELAXED );
+}
+
+static int compare_samples( const void *p1, const void *p2 )
+{
+    const struct profile_entry *e1 = p1, *e2 = p2;
+
+    if (e1->count != e2->count) return e1->count < e2->count ? 1 : -1;
+    return e1->pc < e2->pc ? -1 : e1->pc > e2->pc;
+}
+
+/* get the name of the PE module mapped at base */
+static void get_pe_module_name( void *base, char *name, size_t size )
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const WCHAR *path, *p;
+    size_t i;
+
+    if ((exports = get_module_data_dir( base, IMAGE_FILE_EXPORT_DIRECTORY, NULL )) && exports->Name)
+    {
+        snprintf( name, size, "%s", (const char *)base + exports->Name );
+        return;
+    }
+    if (base == peb->ImageBaseAddress && peb->ProcessParameters &&
+        (path = peb->ProcessParameters->ImagePathName.Buffer))
+    {
+        for (p = path; *path; path++) if (*path == '\\' || *path == '/') p = path + 1;
+        for (i = 0; i < size - 1 && p[i]; i++) name[i] = p[i] < 0x80 ? p[i] : '?';
+        name[i] = 0;
+        return;
+    }
+    snprintf( name, size, "%p", base );
+}
+
+/* write a sample as module+offset, or ELF symbol+offset when dladdr knows it */
+static void write_sample( FILE *file, const struct profile_entry *entry, void **module, char *name, size_t size )
+{
+    MEMORY_BASIC_INFORMATION info;
+    Dl_info dl_info;
+    const char *p;
+
+    if (!NtQueryVirtualMemory( NtCurrentProcess(), (void *)entry->pc, MemoryBasicInformation,
+                               &info, sizeof(info), NULL ) && info.Type == MEM_IMAGE)
+    {
+        if (info.AllocationBase != *module)
+        {
+            *module = info.AllocationBase;
+            get_pe_module_name( *module, name, size );
+        }
+        fprintf( file, "%s+0x%lx %d\n", name, (unsigned long)(entry->pc - (ULONG_PTR)*module ), entry->count );
+    }
+    else if (dladdr( (void *)entry->pc, &dl_info ) && dl_info.dli_fname)
+    {
+        if ((p = strrchr( dl_info.dli_fname, '/' ))) p++;
+        else p = dl_info.dli_fname;
+        if (dl_info.dli_sname)
+            fprintf( file, "%s!%s+0x%lx %d\n", p, dl_info.dli_sname,
+                     (unsigned long)(entry->pc - (ULONG_PTR)dl_info.dli_saddr), entry->count );
+        else
+            fprintf( file, "%s+0x%lx %d\n", p,
+                     (unsigned long)(entry->pc - (ULONG_PTR)dl_info.dli_fbase), entry->count );
+    }
+    else fprintf( file, "0x%lx %d\n", (unsigned long)entry->pc, entry->count );
+}
+
+/***********************************************************************
+ *		profile_finish
+ *
+ * Stop the profiler and write out the samples, most frequent first.
+ */
+void profile_finish(void)
+{
+    static const struct itimerval stop;
+    struct profile_entry *entries;
+    unsigned int i, count = 0;
+    void *module = NULL;
+    char name[MAX_PATH];
+    FILE *file;
+
+    if (!profile_table) return;
+    setitimer( ITIMER_PROF, &stop, NULL );
+
+    if (!(entries = malloc( PROFILE_TABLE_SIZE * sizeof(*entries) ))) return;
+    for (i = 0; i < PROFILE_TABLE_SIZE; i++)
+        if (profile_table[i].count) entries[count++] = profile_table[i];
+    qsort( entries, count, sizeof(*entries), compare_samples );
+
+    if ((file = fopen( profile_file, "w" )))
+    {
+        for (i = 0; i < count; i++) write_sample( file, &entries[i], &module, name, sizeof(name) );
+        if (profile_lost) fprintf( file, "[lost] %d\n", profile_lost );
+        fclose( file );
+    }
+    else perror( profile_file );
+
+    free( entries );
+    munmap( profile_table, PROFILE_TABLE_SIZE * sizeof(*profile_table) );
+    profile_table = NULL;
 }
 
 
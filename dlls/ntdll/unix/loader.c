@@ -1028,7 +1028,7 @@ static inline void *get_rva( void *module, ULONG_PTR addr )
     return (BYTE *)module + addr;
 }
 
-static const void *get_module_data_dir( HMODULE module, ULONG dir, ULONG *size )
+const void *get_module_data_dir( HMODULE module, ULONG dir, ULONG *size )
 {
     const IMAGE_NT_HEADERS *nt = get_rva( module, ((IMAGE_DOS_HEADER *)module)->e_lfanew );
     const IMAGE_DATA_DIRECTORY *data;
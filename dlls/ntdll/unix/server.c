@@ -1456,6 +1456,8 @@ static int init_thread_pipe(void)
  */
 void process_exit_wrapper( int status )
 {
+    profile_finish();
+    dbg_flush();
     close( fd_socket );
     exit( status );
 }
@@ -3070,6 +3070,19 @@ static void quit_handler( int signal, siginfo_t *siginfo, void *ucontext )
 }
 
 
+/**********************************************************************
+ *		prof_handler
+ *
+ * Handler for SIGPROF, used by the sampling profiler.
+ */
+static void prof_handler( int signal, siginfo_t *siginfo, void *sigcontext )
+{
+    ucontext_t *ucontext = sigcontext;
+
+    profile_add_sample( RIP_sig(ucontext) );
+}
+
+
 /**********************************************************************
  *		usr1_handler
  *
@@ -3424,6 +3437,12 @@ void signal_init_process(void)
     if (sigaction( SIGSEGV, &sig_act, NULL ) == -1) goto error;
     if (sigaction( SIGILL, &sig_act, NULL ) == -1) goto error;
     if (sigaction( SIGBUS, &sig_act, NULL ) == -1) goto error;
+    if (profile_init())
+    {
+        sig_act.sa_sigaction = prof_handler;
+        if (sigaction( SIGPROF, &sig_act, NULL ) == -1) goto error;
+        profile_start();
+    }
     install_bpf(&sig_act);
     return;
 
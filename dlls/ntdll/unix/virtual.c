@@ -2538,6 +2538,159 @@ static NTSTATUS get_mapping_info( HANDLE handle, ACCESS_MASK access, unsigned in
 }
 
 
+/* perf map support: with WINEPERFMAP=1, the exports of every mapped image are listed
+ * in /tmp/perf-<pid>.map so that perf and similar tools can symbolize PE code. */
+
+static int perf_map_fd = -1;
+
+struct perf_map_symbol
+{
+    DWORD       rva;
+    const char *name;
+    DWORD       ordinal;
+};
+
+static int compare_perf_map_symbols( const void *p1, const void *p2 )
+{
+    const struct perf_map_symbol *s1 = p1, *s2 = p2;
+
+    if (s1->rva != s2->rva) return s1->rva < s2->rva ? -1 : 1;
+    return !s1->name - !s2->name;  /* named aliases first */
+}
+
+static void perf_map_write( char *base, DWORD start, DWORD end, const char *module, const char *name, DWORD ordinal )
+{
+    char buffer[512];
+    int len;
+
+    if (end <= start) return;
+    if (name) len = snprintf( buffer, sizeof(buffer), "%lx %x %s!%s\n",
+                              (unsigned long)(base + start), end - start, module, name );
+    else len = snprintf( buffer, sizeof(buffer), "%lx %x %s!#%u\n",
+                         (unsigned long)(base + start), end - start, module, ordinal );
+    write( perf_map_fd, buffer, min( len, sizeof(buffer) - 1 ));
+}
+
+/***********************************************************************
+ *             perf_map_init
+ *
+ * Open the perf map file if requested with WINEPERFMAP=1.
+ */
+static void perf_map_init(void)
+{
+    const char *env = getenv( "WINEPERFMAP" );
+    char path[64];
+
+    if (!env || !atoi( env )) return;
+    sprintf( path, "/tmp/perf-%u.map", getpid() );
+    perf_map_fd = open( path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644 );
+}
+
+
+/* check that an array of count elements at rva lies within the image */
+static BOOL perf_map_check_range( SIZE_T image_size, DWORD rva, DWORD count, DWORD elem_size )
+{
+    return rva <= image_size && count <= (image_size - rva) / elem_size;
+}
+
+/* return the string at rva if it is terminated within the image */
+static const char *perf_map_get_string( char *base, SIZE_T image_size, DWORD rva )
+{
+    if (!rva || rva >= image_size || !memchr( base + rva, 0, image_size - rva )) return NULL;
+    return base + rva;
+}
+
+
+/***********************************************************************
+ *             perf_map_add_image
+ *
+ * Write the perf map entries for a newly mapped image: every export covers the
+ * space up to the next one, and the code before the first export of a section
+ * is named after the section. The export data comes from the image itself, so
+ * everything it points to is checked against the image size.
+ */
+static void perf_map_add_image( char *base, SIZE_T image_size, const WCHAR *filename )
+{
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)(base + ((const IMAGE_DOS_HEADER *)base)->e_lfanew);
+    const IMAGE_SECTION_HEADER *sec = IMAGE_FIRST_SECTION( nt );
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    struct perf_map_symbol *symbols = NULL;
+    unsigned int i, j, k, count = 0;
+    char module[64], section[IMAGE_SIZEOF_SHORT_NAME + 1];
+    const char *name;
+    const WCHAR *p;
+    ULONG size;
+
+    if ((exports = get_module_data_dir( (HMODULE)base, IMAGE_FILE_EXPORT_DIRECTORY, &size )) &&
+        !perf_map_check_range( image_size, (const char *)exports - base, 1, sizeof(*exports) ))
+    {
+        WARN( "export directory of %p out of bounds\n", base );
+        exports = NULL;
+    }
+
+    if (filename)
+    {
+        for (p = filename; *filename; filename++) if (*filename == '\\' || *filename == '/') p = filename + 1;
+        for (i = 0; i < sizeof(module) - 1 && p[i]; i++) module[i] = p[i] < 0x80 ? p[i] : '?';
+        module[i] = 0;
+    }
+    else if (exports && (name = perf_map_get_string( base, image_size, exports->Name )))
+        snprintf( module, sizeof(module), "%s", name );
+    else snprintf( module, sizeof(module), "%p", base );
+
+    if (exports && exports->NumberOfFunctions &&
+        perf_map_check_range( image_size, exports->AddressOfFunctions, exports->NumberOfFunctions, sizeof(DWORD) ) &&
+        perf_map_check_range( image_size, exports->AddressOfNames, exports->NumberOfNames, sizeof(DWORD) ) &&
+        perf_map_check_range( image_size, exports->AddressOfNameOrdinals, exports->NumberOfNames, sizeof(WORD) ) &&
+        (symbols = malloc( exports->NumberOfFunctions * sizeof(*symbols) )))
+    {
+        const DWORD *functions = (const DWORD *)(base + exports->AddressOfFunctions);
+        const DWORD *names = (const DWORD *)(base + exports->AddressOfNames);
+        const WORD *ordinals = (const WORD *)(base + exports->AddressOfNameOrdinals);
+        DWORD exp_start = (const char *)exports - base;
+
+        for (i = 0; i < exports->NumberOfFunctions; i++)
+        {
+            symbols[i].rva = functions[i];
+            symbols[i].name = NULL;
+            symbols[i].ordinal = exports->Base + i;
+        }
+        for (i = 0; i < exports->NumberOfNames; i++)
+            if (ordinals[i] < exports->NumberOfFunctions)
+                symbols[ordinals[i]].name = perf_map_get_string( base, image_size, names[i] );
+        for (i = 0; i < exports->NumberOfFunctions; i++)
+        {
+            /* skip forwarded entries, they point into the export directory */
+            if (!functions[i] || (functions[i] >= exp_start && functions[i] < exp_start + size)) continue;
+            if (functions[i] >= image_size) continue;
+            symbols[count++] = symbols[i];
+        }
+        qsort( symbols, count, sizeof(*symbols), compare_perf_map_symbols );
+    }
+
+    for (i = j = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
+    {
+        DWORD start = sec->VirtualAddress, end = start + max( sec->Misc.VirtualSize, sec->SizeOfRawData );
+
+        if (!(sec->Characteristics & IMAGE_SCN_MEM_EXECUTE) || start >= image_size) continue;
+        end = min( end, image_size );
+        memcpy( section, sec->Name, IMAGE_SIZEOF_SHORT_NAME );
+        section[IMAGE_SIZEOF_SHORT_NAME] = 0;
+
+        while (j < count && symbols[j].rva < start) j++;
+        perf_map_write( base, start, j < count ? min( symbols[j].rva, end ) : end, module, section, 0 );
+        for (; j < count && symbols[j].rva < end; j = k)
+        {
+            /* aliases of the same function only get one entry */
+            for (k = j + 1; k < count && symbols[k].rva == symbols[j].rva; k++) ;
+            perf_map_write( base, symbols[j].rva, k < count ? min( symbols[k].rva, end ) : end,
+                            module, symbols[j].name, symbols[j].ordinal );
+        }
+    }
+    free( symbols );
+}
+
+
 /***********************************************************************
  *             virtual_map_image
  *
@@ -2605,6 +2758,7 @@ done:
     server_leave_uninterrupted_section( &virtual_mutex, &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (status >= 0 && perf_map_fd != -1) perf_map_add_image( *addr_ptr, *size_ptr, filename );
     return status;
 }
 
@@ -2780,6 +2934,8 @@ void virtual_init(void)
     pthread_mutex_init( &virtual_mutex, &attr );
     pthread_mutexattr_destroy( &attr );
 
+    perf_map_init();
+
     if (preload_info && *preload_info)
         for (i = 0; (*preload_info)[i].size; i++)
             mmap_add_reserved_area( (*preload_info)[i].addr, (*preload_info)[i].size );
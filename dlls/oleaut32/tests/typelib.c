@@ -832,10 +832,13 @@ static void test_TypeInfo(void)
     static WCHAR wszGetTypeInfo[] = { 'G','e','t','T','y','p','e','I','n','f','o',0 };
     static WCHAR wszClone[] = {'C','l','o','n','e',0};
     static WCHAR wszTestDll[] = {'t','e','s','t','.','d','l','l',0};
+    static WCHAR wszGetTypeInfoMixedCase[] = L"gETtYPEiNFO";
+    static WCHAR wszGetTypeInfoSuffix[] = L"GetTypeInfo_";
     OLECHAR* bogus = wszBogus;
     OLECHAR* pwszGetTypeInfo = wszGetTypeInfo;
     OLECHAR* pwszClone = wszClone;
-    DISPID dispidMember;
+    OLECHAR* pwszName;
+    DISPID dispidMember, memid;
     DISPPARAMS dispparams;
     GUID bogusguid = {0x806afb4f,0x13f7,0x42d2,{0x89,0x2c,0x6c,0x97,0xc3,0x6a,0x36,0xc1}};
     static const GUID moduleTestGetDllEntryGuid = {0xf073cd92,0xa199,0x11ea,{0xbb,0x37,0x02,0x42,0xac,0x13,0x00,0x02}};
@@ -950,6 +953,16 @@ static void test_TypeInfo(void)
     hr = ITypeInfo_GetIDsOfNames(pTypeInfo, &pwszGetTypeInfo, 1, &dispidMember);
     ok_ole_success(hr, ITypeInfo_GetIDsOfNames);
 
+    /* names are case insensitive */
+    pwszName = wszGetTypeInfoMixedCase;
+    hr = ITypeInfo_GetIDsOfNames(pTypeInfo, &pwszName, 1, &memid);
+    ok_ole_success(hr, ITypeInfo_GetIDsOfNames);
+    ok(memid == dispidMember, "got memid %#lx, expected %#lx\n", memid, dispidMember);
+
+    pwszName = wszGetTypeInfoSuffix;
+    hr = ITypeInfo_GetIDsOfNames(pTypeInfo, &pwszName, 1, &memid);
+    ok(hr == DISP_E_UNKNOWNNAME, "got %#lx\n", hr);
+
     hr = ITypeInfo_QueryInterface(pTypeInfo, &IID_ITypeInfo2, (void**)&pTypeInfo2);
     ok_ole_success(hr, ITypeInfo_QueryInterface);
 
@@ -6481,6 +6481,21 @@ static void test_VarAdd(void)
     ok(hres == S_OK && EQ_DOUBLE(r, 1212.0), "VarAdd: BSTR value %f, expected %f\n", r, 1212.0);
     VariantClear(&result);
 
+    /* The result may be one of the operands */
+    V_VT(&left) = VT_BSTR;
+    V_BSTR(&left) = lbstr;
+    hres = pVarAdd(&left, &right, &left);
+    ok(hres == S_OK && V_VT(&left) == VT_BSTR, "VarAdd: expected coerced type VT_BSTR, got %s!\n", vtstr(V_VT(&left)));
+    ok(!lstrcmpW(V_BSTR(&left), L"1212"), "VarAdd: got %s\n", wine_dbgstr_w(V_BSTR(&left)));
+    VariantClear(&left);
+
+    V_VT(&left) = VT_I4;
+    V_I4(&left) = 40;
+    V_VT(&right) = VT_I4;
+    V_I4(&right) = 2;
+    hres = pVarAdd(&left, &right, &right);
+    ok(hres == S_OK && V_VT(&right) == VT_I4 && V_I4(&right) == 42, "VarAdd: got %#lx %s\n", hres, wine_dbgstr_variant(&right));
+
     /* Manuly test some VT_CY and VT_DECIMAL variants */
     V_VT(&cy) = VT_CY;
     hres = VarCyFromI4(4711, &V_CY(&cy));
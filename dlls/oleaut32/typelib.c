@@ -1072,6 +1072,7 @@ typedef struct tagTLBImpLib
 typedef struct tagTLBString {
     BSTR str;
     UINT offset;
+    ULONG name_hash;    /* see TLB_name_hash */
     struct list entry;
 } TLBString;
 
@@ -1290,6 +1291,10 @@ typedef struct tagTLBContext
 	void *mapping;        /* memory mapping */
 	MSFT_SegDir * pTblDir;
 	ITypeLibImpl* pLibInfo;
+	TLBString **names;    /* name table, sorted by offset */
+	unsigned int name_cnt;
+	TLBString **strings;  /* string table, sorted by offset */
+	unsigned int string_cnt;
 } TLBContext;
 
 
@@ -1705,13 +1710,48 @@ static inline TLBVarDesc *TLB_get_vardesc_by_memberid(ITypeInfoImpl *typeinfo, M
     return NULL;
 }
 
+/*
+ * Case insensitive hash of identifier-like names, used to skip lstrcmpiW calls
+ * when looking up members by name. Names containing other characters may
+ * compare equal to strings of a different length or with different characters,
+ * so they get a 0 hash and are always compared.
+ */
+static ULONG TLB_name_hash(const WCHAR *name)
+{
+    ULONG hash = 0;
+
+    if (!name)
+        return 0;
+
+    for (; *name; name++)
+    {
+        WCHAR c = *name;
+
+        if (c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        else if (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9') && c != '_')
+            return 0;
+        hash = hash * 31 + c;
+    }
+
+    return hash | 0x80000000;
+}
+
+static inline BOOL TLB_name_equal(const TLBString *str, const OLECHAR *name, ULONG hash)
+{
+    if (hash && str && str->name_hash && str->name_hash != hash)
+        return FALSE;
+    return !lstrcmpiW(TLB_get_bstr(str), name);
+}
+
 static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const OLECHAR *name)
 {
+    ULONG hash = TLB_name_hash(name);
     int i;
 
     for (i = 0; i < typeinfo->typeattr.cVars; ++i)
     {
-        if (!lstrcmpiW(TLB_get_bstr(typeinfo->vardescs[i].Name), name))
+        if (TLB_name_equal(typeinfo->vardescs[i].Name, name, hash))
             return &typeinfo->vardescs[i];
     }
 
@@ -1908,6 +1948,7 @@ static TLBString *TLB_append_str(struct list *string_list, BSTR new_str)
         heap_free(str);
         return NULL;
     }
+    str->name_hash = TLB_name_hash(str->str);
 
     list_add_tail(string_list, &str->entry);
 
@@ -2176,6 +2217,7 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
         tlbstr->offset = offs;
         tlbstr->str = SysAllocStringByteLen(NULL, lengthInChars * sizeof(WCHAR));
         MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, string, -1, tlbstr->str, lengthInChars);
+        tlbstr->name_hash = TLB_name_hash(tlbstr->str);
 
         heap_free(string);
 
@@ -2185,10 +2227,50 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     }
 }
 
+/* Strings are read from the tables in offset order, which allows a binary search. */
+static TLBString **MSFT_IndexStrings(struct list *string_list, unsigned int *cnt)
+{
+    TLBString **index, *tlbstr;
+    unsigned int i = 0;
+
+    *cnt = list_count(string_list);
+    if (!*cnt || !(index = heap_alloc(*cnt * sizeof(*index))))
+        return NULL;
+
+    LIST_FOR_EACH_ENTRY(tlbstr, string_list, TLBString, entry)
+        index[i++] = tlbstr;
+
+    return index;
+}
+
+static TLBString *MSFT_FindString(TLBString **index, unsigned int cnt, int offset)
+{
+    unsigned int lo = 0, hi = cnt, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (index[mid]->offset == offset)
+            return index[mid];
+        if (index[mid]->offset < (UINT)offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
 static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 {
     TLBString *tlbstr;
 
+    if (pcx->names) {
+        tlbstr = MSFT_FindString(pcx->names, pcx->name_cnt, offset);
+        if (tlbstr) TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
+        return tlbstr;
+    }
+
     LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
         if (tlbstr->offset == offset) {
             TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
@@ -2203,6 +2285,12 @@ static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
 {
     TLBString *tlbstr;
 
+    if (pcx->strings) {
+        tlbstr = MSFT_FindString(pcx->strings, pcx->string_cnt, offset);
+        if (tlbstr) TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
+        return tlbstr;
+    }
+
     LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
         if (tlbstr->offset == offset) {
             TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
@@ -2807,6 +2895,7 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
         tlbstr->offset = offs;
         tlbstr->str = SysAllocStringByteLen(NULL, lengthInChars * sizeof(WCHAR));
         MultiByteToWideChar(CP_ACP, MB_PRECOMPOSED, string, -1, tlbstr->str, lengthInChars);
+        tlbstr->name_hash = TLB_name_hash(tlbstr->str);
 
         heap_free(string);
 
@@ -3465,6 +3554,8 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     cx.mapping = pLib;
     cx.pLibInfo = pTypeLibImpl;
     cx.length = dwTLBLength;
+    cx.names = cx.strings = NULL;
+    cx.name_cnt = cx.string_cnt = 0;
 
     /* read header */
     MSFT_ReadLEDWords(&tlbHeader, sizeof(tlbHeader), &cx, 0);
@@ -3497,6 +3588,8 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     MSFT_ReadAllNames(&cx);
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
+    cx.names = MSFT_IndexStrings(&pTypeLibImpl->name_list, &cx.name_cnt);
+    cx.strings = MSFT_IndexStrings(&pTypeLibImpl->string_list, &cx.string_cnt);
 
     /* now fill our internal data */
     /* TLIBATTR fields */
@@ -3657,6 +3750,9 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     }
 #endif
 
+    heap_free(cx.names);
+    heap_free(cx.strings);
+
     TRACE("(%p)\n", pTypeLibImpl);
     return &pTypeLibImpl->ITypeLib2_iface;
 }
@@ -6375,6 +6471,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
+    ULONG hash;
     UINT i, fdc;
 
     TRACE("%p, %s, %d.\n", iface, debugstr_w(*rgszNames), cNames);
@@ -6383,14 +6480,16 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
+    hash = TLB_name_hash(*rgszNames);
     for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
         int j;
         const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
+        if(TLB_name_equal(pFDesc->Name, *rgszNames, hash)) {
             if(cNames) *pMemId=pFDesc->funcdesc.memid;
             for(i=1; i < cNames; i++){
+                hash = TLB_name_hash(rgszNames[i]);
                 for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                    if(TLB_name_equal(pFDesc->pParamDesc[j].Name, rgszNames[i], hash))
                             break;
                 if( j<pFDesc->funcdesc.cParams)
                     pMemId[i]=j;
@@ -2785,6 +2785,21 @@ HRESULT WINAPI VarCmp(LPVARIANT left, LPVARIANT right, LCID lcid, DWORD flags)
 
     TRACE("%s, %s, %#lx, %#lx.\n", debugstr_variant(left), debugstr_variant(right), lcid, flags);
 
+#define _VARCMP(a,b) \
+    (((a) == (b)) ? VARCMP_EQ : (((a) < (b)) ? VARCMP_LT : VARCMP_GT))
+
+    /* Shortcut the most common cases, the coercions below give the same results */
+    if (V_VT(left) == V_VT(right))
+    {
+        switch (V_VT(left))
+        {
+        case VT_I4:
+            return _VARCMP(V_I4(left), V_I4(right));
+        case VT_R8:
+            return _VARCMP(V_R8(left), V_R8(right));
+        }
+    }
+
     lvt = V_VT(left) & VT_TYPEMASK;
     rvt = V_VT(right) & VT_TYPEMASK;
     xmask = (1 << lvt) | (1 << rvt);
@@ -2922,9 +2937,6 @@ HRESULT WINAPI VarCmp(LPVARIANT left, LPVARIANT right, LCID lcid, DWORD flags)
     if (FAILED(rc))
         return rc;
 
-#define _VARCMP(a,b) \
-    (((a) == (b)) ? VARCMP_EQ : (((a) < (b)) ? VARCMP_LT : VARCMP_GT))
-
     switch (vt) {
         case VT_CY:
             return VarCyCmp(V_CY(&lv), V_CY(&rv));
@@ -3226,6 +3238,51 @@ HRESULT WINAPI VarAdd(LPVARIANT left, LPVARIANT right, LPVARIANT result)
 
     TRACE("(%s,%s,%p)\n", debugstr_variant(left), debugstr_variant(right), result);
 
+    /* Shortcut the most common cases without going through the coercions below */
+    if (V_VT(left) == V_VT(right))
+    {
+        switch (V_VT(left))
+        {
+        case VT_I4:
+        {
+            /* I4 overflows to R8 */
+            LONGLONG i8res = (LONGLONG)V_I4(left) + V_I4(right);
+
+            if (i8res == (LONG)i8res)
+            {
+                V_VT(result) = VT_I4;
+                V_I4(result) = i8res;
+            }
+            else
+            {
+                V_VT(result) = VT_R8;
+                V_R8(result) = i8res;
+            }
+            return S_OK;
+        }
+        case VT_R8:
+            r8res = V_R8(left) + V_R8(right);
+            V_VT(result) = VT_R8;
+            V_R8(result) = r8res;
+            return S_OK;
+        case VT_BSTR:
+        {
+            BSTR str;
+
+            hres = VarBstrCat(V_BSTR(left), V_BSTR(right), &str);
+            if (FAILED(hres))
+            {
+                V_VT(result) = VT_EMPTY;
+                V_I4(result) = 0;
+                return hres;
+            }
+            V_VT(result) = VT_BSTR;
+            V_BSTR(result) = str;
+            return S_OK;
+        }
+        }
+    }
+
     VariantInit(&lv);
     VariantInit(&rv);
     VariantInit(&tv);
@@ -541,6 +541,151 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
     }
 }
 
+/* Per-procedure cache of the sizing pass.
+ *
+ * When all the parameters that go on the wire in one direction are base
+ * types, the buffer size for that direction is a constant that can be
+ * computed once from the format string instead of calling a buffer sizer for
+ * each parameter on every call. The entries are never freed; a copy of the
+ * parameter descriptions is kept to detect a different module being loaded at
+ * the same address. */
+struct ndr_proc_info
+{
+    PFORMAT_STRING format;
+    unsigned int number_of_params;
+    BOOL client_fixed;          /* all [in] params are base types */
+    BOOL server_fixed;          /* all [out] and return params are base types */
+    BOOL has_simple_ref;        /* client has to check for NULL ref pointers */
+    ULONG client_size;
+    ULONG server_size;
+    NDR_PARAM_OIF params[1];
+};
+
+#define NDR_PROC_INFO_CACHE_SIZE 256
+#define NDR_PROC_INFO_CACHE_PROBES 4
+
+static struct ndr_proc_info *proc_info_cache[NDR_PROC_INFO_CACHE_SIZE];
+
+static BOOL basetype_buffer_size( unsigned char fc, ULONG *size, ULONG *align )
+{
+    switch (fc)
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+        *size = *align = sizeof(UCHAR);
+        return TRUE;
+    case FC_WCHAR:
+    case FC_SHORT:
+    case FC_USHORT:
+    case FC_ENUM16:
+        *size = *align = sizeof(USHORT);
+        return TRUE;
+    case FC_LONG:
+    case FC_ULONG:
+    case FC_ENUM32:
+    case FC_INT3264:
+    case FC_UINT3264:
+    case FC_FLOAT:
+    case FC_ERROR_STATUS_T:
+        *size = *align = sizeof(ULONG);
+        return TRUE;
+    case FC_DOUBLE:
+    case FC_HYPER:
+        *size = *align = sizeof(ULONGLONG);
+        return TRUE;
+    case FC_IGNORE:
+        *size = 0;
+        *align = 1;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static BOOL calc_fixed_buffer_size( const NDR_PARAM_OIF *params, unsigned int number_of_params,
+                                    BOOL client, ULONG *ret )
+{
+    ULONG size, align, len = 0;
+    unsigned int i;
+
+    for (i = 0; i < number_of_params; i++)
+    {
+        if (client ? !params[i].attr.IsIn : !params[i].attr.IsOut && !params[i].attr.IsReturn)
+            continue;
+        if (!params[i].attr.IsBasetype) return FALSE;
+        if (!basetype_buffer_size( params[i].u.type_format_char, &size, &align )) return FALSE;
+        len = ((len + align - 1) & ~(align - 1)) + size;
+    }
+    *ret = len;
+    return TRUE;
+}
+
+static BOOL proc_info_matches( const struct ndr_proc_info *info, PFORMAT_STRING format,
+                               unsigned int number_of_params )
+{
+    return info->format == format && info->number_of_params == number_of_params &&
+           !memcmp( info->params, format, number_of_params * sizeof(NDR_PARAM_OIF) );
+}
+
+static const struct ndr_proc_info *get_proc_info( const MIDL_STUB_DESC *stub_desc, PFORMAT_STRING format,
+                                                  unsigned int number_of_params )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)format;
+    struct ndr_proc_info *info, *prev;
+    unsigned int i, hash, slot;
+
+    /* old style format strings are converted on the stack */
+    if (!is_oicf_stubdesc( stub_desc )) return NULL;
+
+    hash = ((ULONG_PTR)format >> 2) % NDR_PROC_INFO_CACHE_SIZE;
+    for (i = 0; i < NDR_PROC_INFO_CACHE_PROBES; i++)
+    {
+        slot = (hash + i) % NDR_PROC_INFO_CACHE_SIZE;
+        if (!(info = proc_info_cache[slot])) break;
+        if (proc_info_matches( info, format, number_of_params )) return info;
+    }
+    if (i == NDR_PROC_INFO_CACHE_PROBES) return NULL;
+
+    if (!(info = HeapAlloc( GetProcessHeap(), 0,
+                            FIELD_OFFSET( struct ndr_proc_info, params[number_of_params] ))))
+        return NULL;
+    info->format = format;
+    info->number_of_params = number_of_params;
+    memcpy( info->params, params, number_of_params * sizeof(*params) );
+    info->client_fixed = calc_fixed_buffer_size( params, number_of_params, TRUE, &info->client_size );
+    info->server_fixed = calc_fixed_buffer_size( params, number_of_params, FALSE, &info->server_size );
+    info->has_simple_ref = FALSE;
+    for (i = 0; i < number_of_params; i++)
+        if (params[i].attr.IsSimpleRef) info->has_simple_ref = TRUE;
+
+    TRACE( "format %p, client size %lu (fixed %d), server size %lu (fixed %d)\n", format,
+           info->client_size, info->client_fixed, info->server_size, info->server_fixed );
+
+    if ((prev = InterlockedCompareExchangePointer( (void **)&proc_info_cache[slot], info, NULL )))
+    {
+        /* another thread filled the slot first */
+        HeapFree( GetProcessHeap(), 0, info );
+        return proc_info_matches( prev, format, number_of_params ) ? prev : NULL;
+    }
+    return info;
+}
+
+static void check_null_ref_args( MIDL_STUB_MESSAGE *stub_msg, PFORMAT_STRING format,
+                                 unsigned int number_of_params )
+{
+    const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)format;
+    unsigned int i;
+
+    for (i = 0; i < number_of_params; i++)
+    {
+        unsigned char *arg = stub_msg->StackTop + params[i].stack_offset;
+        if (params[i].attr.IsSimpleRef && !*(unsigned char **)arg)
+            RpcRaiseException(RPC_X_NULL_REF_POINTER);
+    }
+}
+
 static unsigned int type_stack_size(unsigned char fc)
 {
     switch (fc)
@@ -708,6 +853,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header )
 {
     struct ndr_client_call_ctx finally_ctx;
+    const struct ndr_proc_info *proc_info;
     RPC_MESSAGE rpc_msg;
     handle_t hbinding = NULL;
     /* the value to return to the client from the remote procedure */
@@ -795,8 +941,14 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
 
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
-        client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+        if ((proc_info = get_proc_info(stub_desc, format, number_of_params)) && proc_info->client_fixed)
+        {
+            if (proc_info->has_simple_ref) check_null_ref_args(stub_msg, format, number_of_params);
+            stub_msg->BufferLength = proc_info->client_size;
+        }
+        else
+            client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
+                           number_of_params, (unsigned char *)&retval);
 
         /* 3. GETBUFFER */
         TRACE( "GETBUFFER\n" );
@@ -1332,6 +1484,8 @@ LONG WINAPI NdrStubCall2(
     LONG_PTR *retval_ptr = NULL;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* cached sizing information */
+    const struct ndr_proc_info *proc_info;
 
     TRACE("pThis %p, pChannel %p, pRpcMsg %p, pdwStubPhase %p\n", pThis, pChannel, pRpcMsg, pdwStubPhase);
 
@@ -1469,6 +1623,8 @@ LONG WINAPI NdrStubCall2(
     if ((pRpcMsg->DataRepresentation & 0x0000FFFFUL) != NDR_LOCAL_DATA_REPRESENTATION)
         NdrConvert(&stubMsg, pFormat);
 
+    proc_info = get_proc_info(pStubDesc, pFormat, number_of_params);
+
     for (phase = STUBLESS_UNMARSHAL; phase <= STUBLESS_FREE; phase++)
     {
         TRACE("phase = %d\n", phase);
@@ -1522,9 +1678,14 @@ LONG WINAPI NdrStubCall2(
                 stubMsg.Buffer = pRpcMsg->Buffer;
             }
             break;
+        case STUBLESS_CALCSIZE:
+            if (proc_info && proc_info->server_fixed)
+                stubMsg.BufferLength = proc_info->server_size;
+            else
+                retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
+            break;
         case STUBLESS_UNMARSHAL:
         case STUBLESS_INITOUT:
-        case STUBLESS_CALCSIZE:
         case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
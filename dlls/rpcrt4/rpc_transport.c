@@ -68,6 +68,7 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    unsigned char *read_buf;
 } RpcConnection_np;
 
 static RpcConnection *rpcrt4_conn_np_alloc(void)
@@ -445,6 +446,8 @@ static int rpcrt4_conn_np_close(RpcConnection *conn)
         CloseHandle(connection->event_cache);
         connection->event_cache = 0;
     }
+    HeapFree(GetProcessHeap(), 0, connection->read_buf);
+    connection->read_buf = NULL;
     return 0;
 }
 
@@ -468,6 +471,118 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/* The pipes are in message mode and every fragment is sent with a single
+ * write, so a whole fragment can usually be fetched with one read instead of
+ * separate reads for the common header, the rest of the header and the
+ * payload, saving two server round trips per fragment. */
+static RPC_STATUS rpcrt4_conn_np_receive_fragment(RpcConnection *conn, RpcPktHdr **Header, void **Payload)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+    const RpcPktCommonHdr *common_hdr;
+    RPC_STATUS status;
+    DWORD hdr_length, data_length;
+    LONG dwRead, count;
+
+    *Header = NULL;
+    *Payload = NULL;
+
+    TRACE("(%p, %p, %p)\n", conn, Header, Payload);
+
+    if (!connection->read_buf && !(connection->read_buf = HeapAlloc(GetProcessHeap(), 0, RPC_MAX_PACKET_SIZE)))
+        return RPC_S_OUT_OF_RESOURCES;
+    common_hdr = (const RpcPktCommonHdr *)connection->read_buf;
+
+    dwRead = rpcrt4_conn_np_read(conn, connection->read_buf, RPC_MAX_PACKET_SIZE);
+    if (dwRead < 0)
+    {
+        WARN("read failed\n");
+        return RPC_S_CALL_FAILED;
+    }
+    /* the sender may have split the common header across messages */
+    while (dwRead < sizeof(*common_hdr))
+    {
+        count = rpcrt4_conn_np_read(conn, connection->read_buf + dwRead, sizeof(*common_hdr) - dwRead);
+        if (count <= 0)
+        {
+            WARN("Short read of header, %ld bytes\n", dwRead);
+            return RPC_S_CALL_FAILED;
+        }
+        dwRead += count;
+    }
+
+    status = RPCRT4_ValidateCommonHeader(common_hdr);
+    if (status != RPC_S_OK) return status;
+
+    hdr_length = RPCRT4_GetHeaderSize((const RpcPktHdr *)common_hdr);
+    if (hdr_length == 0 || hdr_length > common_hdr->frag_len)
+    {
+        WARN("bad header length %lu, frag_len %u\n", hdr_length, common_hdr->frag_len);
+        return RPC_S_PROTOCOL_ERROR;
+    }
+    if (dwRead > common_hdr->frag_len)
+    {
+        WARN("fragment of %u bytes followed by %ld extra bytes\n", common_hdr->frag_len,
+             dwRead - common_hdr->frag_len);
+        return RPC_S_PROTOCOL_ERROR;
+    }
+
+    *Header = HeapAlloc(GetProcessHeap(), 0, hdr_length);
+    if (!*Header)
+        return RPC_S_OUT_OF_RESOURCES;
+
+    /* complete the header if it didn't fit into the first read */
+    if (dwRead < hdr_length)
+    {
+        memcpy(*Header, connection->read_buf, dwRead);
+        count = rpcrt4_conn_np_read(conn, (unsigned char *)*Header + dwRead, hdr_length - dwRead);
+        if (count != hdr_length - dwRead)
+        {
+            WARN("bad header length, %ld bytes, hdr_length %ld\n", dwRead, hdr_length);
+            status = RPC_S_CALL_FAILED;
+            goto fail;
+        }
+        dwRead = hdr_length;
+    }
+    else
+        memcpy(*Header, connection->read_buf, hdr_length);
+
+    data_length = (*Header)->common.frag_len - hdr_length;
+    if (data_length)
+    {
+        DWORD have = dwRead - hdr_length;
+
+        *Payload = HeapAlloc(GetProcessHeap(), 0, data_length);
+        if (!*Payload)
+        {
+            status = RPC_S_OUT_OF_RESOURCES;
+            goto fail;
+        }
+        memcpy(*Payload, connection->read_buf + hdr_length, have);
+
+        /* fragments larger than our buffer or split by the sender */
+        while (have < data_length)
+        {
+            count = rpcrt4_conn_np_read(conn, (unsigned char *)*Payload + have, data_length - have);
+            if (count <= 0)
+            {
+                WARN("bad data length, %ld/%ld\n", have, data_length);
+                status = RPC_S_CALL_FAILED;
+                goto fail;
+            }
+            have += count;
+        }
+    }
+
+    return RPC_S_OK;
+
+fail:
+    RPCRT4_FreeHeader(*Header);
+    *Header = NULL;
+    HeapFree(GetProcessHeap(), 0, *Payload);
+    *Payload = NULL;
+    return status;
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3127,7 +3242,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncacn_np_get_top_of_tower,
     rpcrt4_ncacn_np_parse_top_of_tower,
-    NULL,
+    rpcrt4_conn_np_receive_fragment,
     RPCRT4_default_is_authorized,
     RPCRT4_default_authorize,
     RPCRT4_default_secure_packet,
@@ -3149,7 +3264,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
-    NULL,
+    rpcrt4_conn_np_receive_fragment,
     rpcrt4_ncalrpc_is_authorized,
     rpcrt4_ncalrpc_authorize,
     rpcrt4_ncalrpc_secure_packet,
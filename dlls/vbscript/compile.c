@@ -549,6 +549,65 @@ static HRESULT compile_binary_expression(compile_ctx_t *ctx, binary_expression_t
     return push_instr(ctx, op) ? S_OK : E_OUTOFMEMORY;
 }
 
+static BOOL get_string_concat_len(expression_t *expr, size_t *len)
+{
+    switch(expr->type) {
+    case EXPR_BRACKETS:
+        return get_string_concat_len(((unary_expression_t*)expr)->subexpr, len);
+    case EXPR_CONCAT:
+        return get_string_concat_len(((binary_expression_t*)expr)->left, len)
+            && get_string_concat_len(((binary_expression_t*)expr)->right, len);
+    case EXPR_STRING:
+        *len += lstrlenW(((string_expression_t*)expr)->value);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static WCHAR *copy_string_concat(expression_t *expr, WCHAR *ptr)
+{
+    size_t len;
+
+    switch(expr->type) {
+    case EXPR_BRACKETS:
+        return copy_string_concat(((unary_expression_t*)expr)->subexpr, ptr);
+    case EXPR_CONCAT:
+        ptr = copy_string_concat(((binary_expression_t*)expr)->left, ptr);
+        return copy_string_concat(((binary_expression_t*)expr)->right, ptr);
+    case EXPR_STRING:
+        len = lstrlenW(((string_expression_t*)expr)->value);
+        memcpy(ptr, ((string_expression_t*)expr)->value, len * sizeof(WCHAR));
+        return ptr + len;
+    default:
+        assert(0);
+        return ptr;
+    }
+}
+
+static HRESULT compile_concat_expression(compile_ctx_t *ctx, binary_expression_t *expr)
+{
+    unsigned instr;
+    size_t len = 0;
+    WCHAR *str;
+
+    /* Fold concatenations of string literals into a single string. */
+    if(!get_string_concat_len(&expr->expr, &len))
+        return compile_binary_expression(ctx, expr, OP_concat);
+
+    str = compiler_alloc(ctx->code, (len + 1) * sizeof(WCHAR));
+    if(!str)
+        return E_OUTOFMEMORY;
+    *copy_string_concat(&expr->expr, str) = 0;
+
+    instr = push_instr(ctx, OP_string);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->arg1.str = str;
+    return S_OK;
+}
+
 static HRESULT compile_expression(compile_ctx_t *ctx, expression_t *expr)
 {
     switch(expr->type) {
@@ -563,7 +622,7 @@ static HRESULT compile_expression(compile_ctx_t *ctx, expression_t *expr)
     case EXPR_CALL:
         return compile_call_expression(ctx, (call_expression_t*)expr, TRUE);
     case EXPR_CONCAT:
-        return compile_binary_expression(ctx, (binary_expression_t*)expr, OP_concat);
+        return compile_concat_expression(ctx, (binary_expression_t*)expr);
     case EXPR_DATE:
         return push_instr_date(ctx, OP_date, ((date_expression_t*)expr)->value);
     case EXPR_DIV:
@@ -1484,6 +1543,49 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+/*
+ * Identifiers referring to local variables or arguments can't be shadowed by
+ * anything else, so once all Dim statements of the function are known, we can
+ * replace their lookups by name with direct slot access.
+ */
+static void resolve_local_idents(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr, *end = ctx->code->instrs + ctx->instr_cnt;
+    unsigned i;
+
+    if(func->type == FUNC_GLOBAL)
+        return;
+
+    for(instr = ctx->code->instrs + func->code_off; instr < end; instr++) {
+        if(instr->op != OP_ident)
+            continue;
+
+        /* function name refers to its return value, see interp_ident */
+        if((func->type == FUNC_FUNCTION || func->type == FUNC_PROPGET)
+           && !wcsicmp(instr->arg1.bstr, func->name))
+            continue;
+
+        for(i = 0; i < func->var_cnt; i++) {
+            if(!wcsicmp(func->vars[i].name, instr->arg1.bstr))
+                break;
+        }
+        if(i < func->var_cnt) {
+            instr->op = OP_local;
+            instr->arg1.lng = i;
+            continue;
+        }
+
+        for(i = 0; i < func->arg_cnt; i++) {
+            if(!wcsicmp(func->args[i].name, instr->arg1.bstr))
+                break;
+        }
+        if(i < func->arg_cnt) {
+            instr->op = OP_local;
+            instr->arg1.lng = -1 - (int)i;
+        }
+    }
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1553,6 +1655,8 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         assert(i == func->var_cnt);
     }
 
+    resolve_local_idents(ctx, func);
+
     if(func->array_cnt) {
         unsigned array_id = 0;
         dim_decl_t *dim_decl;
@@ -23,6 +23,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(vbscript);
+WINE_DECLARE_DEBUG_CHANNEL(vbscript_ops);
 
 static DISPID propput_dispid = DISPID_PROPERTYPUT;
 
@@ -822,6 +823,21 @@ static HRESULT interp_ident(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    const int arg = ctx->instr->arg1.lng;
+    VARIANT v, *var;
+
+    TRACE("%d\n", arg);
+
+    /* Local variables and arguments resolved by the compiler, see resolve_local_idents. */
+    var = arg >= 0 ? ctx->vars + arg : ctx->args - arg - 1;
+
+    V_VT(&v) = VT_BYREF|VT_VARIANT;
+    V_BYREF(&v) = V_VT(var) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(var) : var;
+    return stack_push(ctx, &v);
+}
+
 static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD flags)
 {
     VARIANT value;
@@ -2411,6 +2427,7 @@ static void release_exec(exec_ctx_t *ctx)
 HRESULT exec_script(script_ctx_t *ctx, BOOL extern_caller, function_t *func, vbdisp_t *vbthis, DISPPARAMS *dp, VARIANT *res)
 {
     exec_ctx_t exec = {func->code_ctx};
+    unsigned op_cnt = 0;
     vbsop_t op;
     HRESULT hres = S_OK;
 
@@ -2487,6 +2504,7 @@ HRESULT exec_script(script_ctx_t *ctx, BOOL extern_caller, function_t *func, vbd
 
     while(exec.instr) {
         op = exec.instr->op;
+        op_cnt++;
         hres = op_funcs[op](&exec);
         if(FAILED(hres)) {
             if(hres != SCRIPT_E_RECORDED) {
@@ -2548,6 +2566,8 @@ HRESULT exec_script(script_ctx_t *ctx, BOOL extern_caller, function_t *func, vbd
 
     assert(!exec.top);
 
+    TRACE_(vbscript_ops)("%s: %u ops executed\n", debugstr_w(func->name), op_cnt);
+
     if(extern_caller) {
         if(FAILED(hres)) {
             if(!ctx->ei.scode)
@@ -1067,6 +1067,17 @@ static inline HRESULT read_utf8_char( struct reader *reader, unsigned int *ret,
     return WS_E_INVALID_FORMAT;
 }
 
+/* skip buffered ASCII characters up to the given delimiter, returns the number of bytes skipped */
+static inline unsigned int read_skip_ascii( struct reader *reader, unsigned char delim )
+{
+    const unsigned char *start = read_current_ptr( reader ), *end = reader->read_bufptr + reader->read_size, *ptr;
+
+    for (ptr = start; ptr < end && *ptr < 0x80 && *ptr != delim; ptr++)
+        ;
+    read_skip( reader, ptr - start );
+    return ptr - start;
+}
+
 static inline BOOL read_isnamechar( unsigned int ch )
 {
     /* FIXME: incomplete */
@@ -1359,6 +1370,7 @@ static HRESULT read_attribute_value_text( struct reader *reader, WS_XML_ATTRIBUT
     start = read_current_ptr( reader );
     for (;;)
     {
+        len += read_skip_ascii( reader, quote );
         if ((hr = read_utf8_char( reader, &ch, &skip )) != S_OK) return hr;
         if (ch == quote) break;
         read_skip( reader, skip );
@@ -2165,6 +2177,7 @@ static HRESULT read_text_text( struct reader *reader )
     start = read_current_ptr( reader );
     for (;;)
     {
+        len += read_skip_ascii( reader, '<' );
         if (read_end_of_data( reader )) break;
         if ((hr = read_utf8_char( reader, &ch, &skip )) != S_OK) return hr;
         if (ch == '<') break;
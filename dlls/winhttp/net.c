@@ -289,6 +289,7 @@ void netconn_close( struct netconn *conn )
     }
     if (conn->socket != -1)
         closesocket( conn->socket );
+    release_host_connection( conn->host );
     release_host( conn->host );
     if (conn->port)
         CloseHandle( conn->port );
@@ -1421,7 +1421,42 @@ static CRITICAL_SECTION_DEBUG connection_pool_debug =
 };
 static CRITICAL_SECTION connection_pool_cs = { &connection_pool_debug, -1, 0, 0, 0, 0 };
 
-static struct list connection_pool = LIST_INIT( connection_pool );
+/* signalled when a connection is returned to the pool or closed */
+static CONDITION_VARIABLE connection_pool_cv = CONDITION_VARIABLE_INIT;
+static INIT_ONCE connection_pool_once = INIT_ONCE_STATIC_INIT;
+
+/* hosts are hashed on name, tunnel destination, port and security */
+#define CONNECTION_POOL_BUCKETS 64
+static struct list connection_pool[CONNECTION_POOL_BUCKETS];
+
+/* idle connections kept per host, independent of the per-server connection limit */
+#define MAX_IDLE_CONNECTIONS_PER_HOST 32
+
+/* the pool is shared by all sessions, so is the limit on connections per server */
+static DWORD max_conns_per_server = ~0u;
+
+static BOOL WINAPI init_connection_pool( INIT_ONCE *once, void *param, void **ctx )
+{
+    unsigned int i;
+
+    for (i = 0; i < CONNECTION_POOL_BUCKETS; i++) list_init( &connection_pool[i] );
+    return TRUE;
+}
+
+static unsigned int hash_host( const WCHAR *hostname, const WCHAR *tunnel_host, INTERNET_PORT port, BOOL secure )
+{
+    unsigned int hash = port * 2 + !!secure;
+    const WCHAR *p;
+
+    for (p = hostname; *p; p++) hash = hash * 31 + *p;
+    if (tunnel_host) for (p = tunnel_host; *p; p++) hash = hash * 31 + *p;
+    return hash;
+}
+
+static struct list *get_pool_bucket( unsigned int hash )
+{
+    return &connection_pool[hash % CONNECTION_POOL_BUCKETS];
+}
 
 void release_host( struct hostdata *host )
 {
@@ -1432,11 +1467,37 @@ void release_host( struct hostdata *host )
     LeaveCriticalSection( &connection_pool_cs );
     if (ref) return;
 
+    TRACE( "%s:%u: %ld connections created, %ld reused\n", debugstr_w(host->hostname), host->port,
+           host->created, host->reused );
+
     assert( list_empty( &host->connections ) );
     free( host->hostname );
+    free( host->tunnel_host );
     free( host );
 }
 
+/* gives back the connection slot taken in open_connection */
+void release_host_connection( struct hostdata *host )
+{
+    EnterCriticalSection( &connection_pool_cs );
+    host->conn_count--;
+    LeaveCriticalSection( &connection_pool_cs );
+    WakeAllConditionVariable( &connection_pool_cv );
+}
+
+DWORD get_max_conns_per_server( void )
+{
+    return max_conns_per_server;
+}
+
+void set_max_conns_per_server( DWORD max_conns )
+{
+    EnterCriticalSection( &connection_pool_cs );
+    max_conns_per_server = max_conns;
+    LeaveCriticalSection( &connection_pool_cs );
+    WakeAllConditionVariable( &connection_pool_cv );
+}
+
 static BOOL connection_collector_running;
 
 static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void *ctx )
@@ -1444,6 +1505,7 @@ static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void
     unsigned int remaining_connections;
     struct netconn *netconn, *next_netconn;
     struct hostdata *host, *next_host;
+    unsigned int i;
     ULONGLONG now;
 
     do
@@ -1455,20 +1517,25 @@ static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void
 
         EnterCriticalSection(&connection_pool_cs);
 
-        LIST_FOR_EACH_ENTRY_SAFE(host, next_host, &connection_pool, struct hostdata, entry)
+        for (i = 0; i < CONNECTION_POOL_BUCKETS; i++)
         {
-            LIST_FOR_EACH_ENTRY_SAFE(netconn, next_netconn, &host->connections, struct netconn, entry)
+            LIST_FOR_EACH_ENTRY_SAFE(host, next_host, &connection_pool[i], struct hostdata, entry)
             {
-                if (netconn->keep_until < now)
+                LIST_FOR_EACH_ENTRY_SAFE(netconn, next_netconn, &host->connections, struct netconn, entry)
                 {
-                    TRACE("freeing %p\n", netconn);
-                    list_remove(&netconn->entry);
-                    netconn_close(netconn);
+                    if (netconn->keep_until < now)
+                    {
+                        TRACE("freeing %p\n", netconn);
+                        list_remove(&netconn->entry);
+                        host->idle_count--;
+                        netconn_close(netconn);
+                    }
+                    else remaining_connections++;
                 }
-                else remaining_connections++;
             }
         }
 
+        TRACE("%u idle connections left in pool\n", remaining_connections);
         if (!remaining_connections) connection_collector_running = FALSE;
 
         LeaveCriticalSection(&connection_pool_cs);
@@ -1477,14 +1544,23 @@ static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void
     FreeLibraryWhenCallbackReturns( instance, winhttp_instance );
 }
 
-static void cache_connection( struct netconn *netconn )
+static void cache_connection( struct netconn *netconn, DWORD keep_alive )
 {
-    TRACE( "caching connection %p\n", netconn );
-
     EnterCriticalSection( &connection_pool_cs );
 
-    netconn->keep_until = GetTickCount64() + DEFAULT_KEEP_ALIVE_TIMEOUT;
+    if (netconn->host->idle_count >= MAX_IDLE_CONNECTIONS_PER_HOST)
+    {
+        LeaveCriticalSection( &connection_pool_cs );
+        TRACE( "too many idle connections to host, closing %p\n", netconn );
+        netconn_close( netconn );
+        return;
+    }
+
+    TRACE( "caching connection %p for %lu ms\n", netconn, keep_alive );
+
+    netconn->keep_until = GetTickCount64() + keep_alive;
     list_add_head( &netconn->host->connections, &netconn->entry );
+    netconn->host->idle_count++;
 
     if (!connection_collector_running)
     {
@@ -1497,6 +1573,7 @@ static void cache_connection( struct netconn *netconn )
     }
 
     LeaveCriticalSection( &connection_pool_cs );
+    WakeAllConditionVariable( &connection_pool_cv );
 }
 
 static DWORD map_secure_protocols( DWORD mask )
@@ -1541,14 +1618,64 @@ static DWORD ensure_cred_handle( struct request *request )
     return ERROR_SUCCESS;
 }
 
+/* Takes an idle connection to the host or, if none is available, a slot for a new one, waiting
+ * for a connection to be returned or closed while the per-server limit is reached. *ret_conn is
+ * set to NULL when a slot was taken; it has to be given back with release_host_connection() if
+ * no connection ends up being created.
+ */
+static DWORD get_host_connection( struct request *request, struct hostdata *host, struct netconn **ret_conn )
+{
+    int timeout = request->connect_timeout;
+    ULONGLONG now, end = GetTickCount64() + timeout;
+    DWORD ret = ERROR_SUCCESS;
+
+    *ret_conn = NULL;
+
+    EnterCriticalSection( &connection_pool_cs );
+    for (;;)
+    {
+        if (!list_empty( &host->connections ))
+        {
+            *ret_conn = LIST_ENTRY( list_head( &host->connections ), struct netconn, entry );
+            list_remove( &(*ret_conn)->entry );
+            host->idle_count--;
+            break;
+        }
+        if (host->conn_count < max_conns_per_server)
+        {
+            host->conn_count++;
+            break;
+        }
+
+        TRACE( "%u connections open to %s, waiting\n", host->conn_count, debugstr_w(host->hostname) );
+        if (timeout <= 0)
+        {
+            SleepConditionVariableCS( &connection_pool_cv, &connection_pool_cs, INFINITE );
+            continue;
+        }
+        if ((now = GetTickCount64()) >= end ||
+            !SleepConditionVariableCS( &connection_pool_cv, &connection_pool_cs, end - now ))
+        {
+            if (!list_empty( &host->connections ) || host->conn_count < max_conns_per_server) continue;
+            ret = ERROR_WINHTTP_TIMEOUT;
+            break;
+        }
+    }
+    LeaveCriticalSection( &connection_pool_cs );
+    return ret;
+}
+
 static DWORD open_connection( struct request *request )
 {
     BOOL is_secure = request->hdr.flags & WINHTTP_FLAG_SECURE;
     struct hostdata *host = NULL, *iter;
     struct netconn *netconn = NULL;
     struct connect *connect;
+    const WCHAR *tunnel_host = NULL;
     WCHAR *addressW = NULL;
+    struct list *bucket;
     INTERNET_PORT port;
+    unsigned int hash;
     DWORD ret, len;
 
     if (request->netconn) goto done;
@@ -1556,11 +1683,20 @@ static DWORD open_connection( struct request *request )
     connect = request->connect;
     port = connect->serverport ? connect->serverport : (request->hdr.flags & WINHTTP_FLAG_SECURE ? 443 : 80);
 
+    /* a tunnel through a proxy can only be reused for the same destination */
+    if (is_secure && connect->session->proxy_server && wcsicmp( connect->hostname, connect->servername ))
+        tunnel_host = connect->hostname;
+    hash = hash_host( connect->servername, tunnel_host, port, is_secure );
+
+    InitOnceExecuteOnce( &connection_pool_once, init_connection_pool, NULL, NULL );
     EnterCriticalSection( &connection_pool_cs );
 
-    LIST_FOR_EACH_ENTRY( iter, &connection_pool, struct hostdata, entry )
+    bucket = get_pool_bucket( hash );
+    LIST_FOR_EACH_ENTRY( iter, bucket, struct hostdata, entry )
     {
-        if (iter->port == port && !wcscmp( connect->servername, iter->hostname ) && !is_secure == !iter->secure)
+        if (iter->hash == hash && iter->port == port && !wcscmp( connect->servername, iter->hostname ) &&
+            !is_secure == !iter->secure &&
+            (tunnel_host ? iter->tunnel_host && !wcscmp( tunnel_host, iter->tunnel_host ) : !iter->tunnel_host))
         {
             host = iter;
             host->ref++;
@@ -1570,18 +1706,21 @@ static DWORD open_connection( struct request *request )
 
     if (!host)
     {
-        if ((host = malloc( sizeof(*host) )))
+        if ((host = calloc( 1, sizeof(*host) )))
         {
             host->ref = 1;
+            host->hash = hash;
             host->secure = is_secure;
             host->port = port;
             list_init( &host->connections );
-            if ((host->hostname = strdupW( connect->servername )))
+            if ((host->hostname = strdupW( connect->servername )) &&
+                (!tunnel_host || (host->tunnel_host = strdupW( tunnel_host ))))
             {
-                list_add_head( &connection_pool, &host->entry );
+                list_add_head( bucket, &host->entry );
             }
             else
             {
+                free( host->hostname );
                 free( host );
                 host = NULL;
             }
@@ -1594,16 +1733,18 @@ static DWORD open_connection( struct request *request )
 
     for (;;)
     {
-        EnterCriticalSection( &connection_pool_cs );
-        if (!list_empty( &host->connections ))
+        if ((ret = get_host_connection( request, host, &netconn )))
         {
-            netconn = LIST_ENTRY( list_head( &host->connections ), struct netconn, entry );
-            list_remove( &netconn->entry );
+            release_host( host );
+            return ret;
         }
-        LeaveCriticalSection( &connection_pool_cs );
         if (!netconn) break;
 
-        if (netconn_is_alive( netconn )) break;
+        if (netconn_is_alive( netconn ))
+        {
+            InterlockedIncrement( &host->reused );
+            break;
+        }
         TRACE("connection %p no longer alive, closing\n", netconn);
         netconn_close( netconn );
         netconn = NULL;
@@ -1622,6 +1763,7 @@ static DWORD open_connection( struct request *request )
 
         if ((ret = netconn_resolve( host->hostname, port, &connect->sockaddr, request->resolve_timeout )))
         {
+            release_host_connection( host );
             release_host( host );
             return ret;
         }
@@ -1629,6 +1771,7 @@ static DWORD open_connection( struct request *request )
 
         if (!(addressW = addr_to_str( &connect->sockaddr )))
         {
+            release_host_connection( host );
             release_host( host );
             return ERROR_OUTOFMEMORY;
         }
@@ -1640,6 +1783,7 @@ static DWORD open_connection( struct request *request )
     {
         if (!addressW && !(addressW = addr_to_str( &connect->sockaddr )))
         {
+            release_host_connection( host );
             release_host( host );
             return ERROR_OUTOFMEMORY;
         }
@@ -1652,9 +1796,11 @@ static DWORD open_connection( struct request *request )
         if ((ret = netconn_create( host, &connect->sockaddr, request->connect_timeout, &netconn )))
         {
             free( addressW );
+            release_host_connection( host );
             release_host( host );
             return ret;
         }
+        InterlockedIncrement( &host->created );
         netconn_set_timeout( netconn, TRUE, request->send_timeout );
         netconn_set_timeout( netconn, FALSE, request->receive_response_timeout );
 
@@ -1880,11 +2026,33 @@ static DWORD refill_buffer( struct request *request, BOOL notify )
     return ERROR_SUCCESS;
 }
 
+/* return the keep-alive timeout in milliseconds, as limited by the server */
+static DWORD get_keep_alive_timeout( struct request *request )
+{
+    WCHAR buf[64], *p = buf;
+    DWORD timeout, size = sizeof(buf);
+
+    if (query_headers( request, WINHTTP_QUERY_CUSTOM, L"Keep-Alive", buf, &size, NULL ))
+        return DEFAULT_KEEP_ALIVE_TIMEOUT;
+
+    while (*p)
+    {
+        while (*p == ' ' || *p == ',') p++;
+        if (!wcsnicmp( p, L"timeout=", 8 ))
+        {
+            timeout = wcstoul( p + 8, NULL, 10 );
+            return timeout < DEFAULT_KEEP_ALIVE_TIMEOUT / 1000 ? timeout * 1000 : DEFAULT_KEEP_ALIVE_TIMEOUT;
+        }
+        while (*p && *p != ',') p++;
+    }
+    return DEFAULT_KEEP_ALIVE_TIMEOUT;
+}
+
 static void finished_reading( struct request *request )
 {
     BOOL close = FALSE;
     WCHAR connection[20];
-    DWORD size = sizeof(connection);
+    DWORD size = sizeof(connection), keep_alive = 0;
 
     if (!request->netconn) return;
 
@@ -1897,10 +2065,12 @@ static void finished_reading( struct request *request )
     }
     else if (!wcscmp( request->version, L"HTTP/1.0" )) close = TRUE;
 
+    if (!close && !(keep_alive = get_keep_alive_timeout( request ))) close = TRUE;
+
     if (close)
         netconn_close( request->netconn );
     else
-        cache_connection( request->netconn );
+        cache_connection( request->netconn, keep_alive );
     request->netconn = NULL;
 }
 
@@ -1920,16 +2090,62 @@ static BOOL end_of_read_data( struct request *request )
     return (request->content_length == request->content_read);
 }
 
+/* return the amount of body data that can be received straight into a caller's buffer of the given size */
+static DWORD get_direct_read_size( struct request *request, DWORD size )
+{
+    /* small reads are better served by filling the read buffer */
+    if (request->read_size || size < sizeof(request->read_buf)) return 0;
+
+    if (request->read_chunked)
+    {
+        if (request->read_chunked_size == ~0u) return 0;
+        return min( size, request->read_chunked_size );
+    }
+    if (request->content_length != ~0u) return min( size, request->content_length - request->content_read );
+    return size;
+}
+
+/* receive body data bypassing the read buffer */
+static DWORD read_direct( struct request *request, char *buffer, DWORD size, int *count, BOOL notify )
+{
+    DWORD ret;
+
+    if (notify) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_RECEIVING_RESPONSE, NULL, 0 );
+
+    ret = netconn_recv( request->netconn, buffer, size, 0, count );
+
+    if (notify) send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_RESPONSE_RECEIVED, count, sizeof(*count) );
+
+    if (!ret && !*count)
+    {
+        /* connection closed before the end of the body */
+        request->content_length = request->content_read = 0;
+        if (request->read_chunked) request->read_chunked_size = 0;
+    }
+    return ret;
+}
+
 static DWORD read_data( struct request *request, void *buffer, DWORD size, DWORD *read, BOOL async )
 {
     int count, bytes_read = 0;
-    DWORD ret = ERROR_SUCCESS;
+    DWORD ret = ERROR_SUCCESS, direct;
 
     if (end_of_read_data( request )) goto done;
 
     while (size)
     {
-        if (!(count = get_available_data( request )))
+        if (!(count = get_available_data( request )) && (direct = get_direct_read_size( request, size )))
+        {
+            if ((ret = read_direct( request, (char *)buffer + bytes_read, direct, &count, async ))) goto done;
+            if (!count) goto done;
+            if (request->read_chunked) request->read_chunked_size -= count;
+            size -= count;
+            bytes_read += count;
+            request->content_read += count;
+            if (end_of_read_data( request )) goto done;
+            continue;
+        }
+        if (!count)
         {
             if ((ret = refill_buffer( request, async ))) goto done;
             if (!(count = get_available_data( request ))) goto done;
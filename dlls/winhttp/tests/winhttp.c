@@ -147,6 +147,30 @@ static void test_WinHttpQueryOption(void)
     ok(feature == WINHTTP_OPTION_REDIRECT_POLICY_ALWAYS,
        "expected WINHTTP_OPTION_REDIRECT_POLICY_ALWAYS, got %#lx\n", feature);
 
+    feature = 4;
+    SetLastError(0xdeadbeef);
+    ret = WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, sizeof(feature));
+    ok(ret, "failed to set max connections per server %lu\n", GetLastError());
+
+    feature = 0xdeadbeef;
+    size = sizeof(feature);
+    SetLastError(0xdeadbeef);
+    ret = WinHttpQueryOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, &size);
+    ok(ret, "failed to query option %lu\n", GetLastError());
+    ok(feature == 4, "expected 4, got %lu\n", feature);
+
+    feature = 0;
+    SetLastError(0xdeadbeef);
+    ret = WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, sizeof(feature));
+    ok(!ret, "should fail to set max connections per server to 0\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "expected ERROR_INVALID_PARAMETER, got %lu\n", GetLastError());
+
+    feature = 0xdeadbeef;
+    size = sizeof(feature);
+    ret = WinHttpQueryOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, &size);
+    ok(ret, "failed to query option %lu\n", GetLastError());
+    ok(feature == 4, "expected 4, got %lu\n", feature);
+
     feature = WINHTTP_DISABLE_COOKIES;
     SetLastError(0xdeadbeef);
     ret = WinHttpSetOption(session, WINHTTP_OPTION_DISABLE_FEATURE, &feature, sizeof(feature));
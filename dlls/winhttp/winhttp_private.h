@@ -60,10 +60,16 @@ struct hostdata
 {
     struct list entry;
     LONG ref;
+    unsigned int hash;
     WCHAR *hostname;
+    WCHAR *tunnel_host; /* destination host of a secure connection through a proxy */
     INTERNET_PORT port;
     BOOL secure;
     struct list connections;
+    unsigned int idle_count;
+    unsigned int conn_count; /* open connections, idle or in use */
+    LONG reused;
+    LONG created;
 };
 
 struct session
@@ -387,6 +393,9 @@ BOOL set_server_for_hostname( struct connect *, const WCHAR *, INTERNET_PORT ) D
 void destroy_authinfo( struct authinfo * ) DECLSPEC_HIDDEN;
 
 void release_host( struct hostdata * ) DECLSPEC_HIDDEN;
+void release_host_connection( struct hostdata * ) DECLSPEC_HIDDEN;
+DWORD get_max_conns_per_server( void ) DECLSPEC_HIDDEN;
+void set_max_conns_per_server( DWORD ) DECLSPEC_HIDDEN;
 DWORD process_header( struct request *, const WCHAR *, const WCHAR *, DWORD, BOOL ) DECLSPEC_HIDDEN;
 
 extern HRESULT WinHttpRequest_create( void ** ) DECLSPEC_HIDDEN;
@@ -182,6 +182,7 @@ typedef struct
     char *cache_prefix; /* string that has to be prefixed for this container to be used */
     LPWSTR path; /* path to url container directory */
     HANDLE mapping; /* handle of file mapping */
+    urlcache_header *header; /* view of the mapping, kept between index locks */
     DWORD file_size; /* size of file when mapping was opened */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
@@ -670,6 +671,11 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    if (pContainer->header)
+    {
+        UnmapViewOfFile(pContainer->header);
+        pContainer->header = NULL;
+    }
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
 }
@@ -686,6 +692,7 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
     }
 
     pContainer->mapping = NULL;
+    pContainer->header = NULL;
     pContainer->file_size = 0;
     pContainer->default_entry_type = default_entry_type;
 
@@ -881,29 +888,29 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
 static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     urlcache_header* pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    /* the view stays mapped between locks, so that the common case
+     * doesn't need to map and unmap the index for every operation */
+    if (!pContainer->header)
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-    if (!pIndexData)
+    if (!(pHeader = pContainer->header))
     {
         ReleaseMutex(pContainer->mutex);
         ERR("Couldn't MapViewOfFile. Error: %ld\n", GetLastError());
         return NULL;
     }
-    pHeader = (urlcache_header*)pIndexData;
 
     /* file has grown - we need to remap to prevent us getting
      * access violations when we try and access beyond the end
      * of the memory mapped file */
     if (pHeader->size != pContainer->file_size)
     {
-        UnmapViewOfFile( pHeader );
         cache_container_close_index(pContainer);
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
@@ -912,15 +919,14 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-        if (!pIndexData)
+        if (!(pHeader = pContainer->header))
         {
             ReleaseMutex(pContainer->mutex);
             ERR("Couldn't MapViewOfFile. Error: %ld\n", GetLastError());
             return NULL;
         }
-        pHeader = (urlcache_header*)pIndexData;
     }
 
     TRACE("Signature: %s, file size: %ld bytes\n", pHeader->signature, pHeader->size);
@@ -939,9 +945,8 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
-    /* release mutex */
-    ReleaseMutex(pContainer->mutex);
-    return UnmapViewOfFile(pHeader);
+    /* release mutex, the view is unmapped when the index is closed */
+    return ReleaseMutex(pContainer->mutex);
 }
 
 /***********************************************************************
@@ -1170,16 +1175,21 @@ static DWORD cache_container_clean_index(cache_container *container, urlcache_he
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    /* Detach the current view so that closing the index doesn't unmap it. If
+     * the index can't be reopened or mapped, the caller keeps working on the
+     * old view, which stays owned by the container and remains valid. */
+    container->header = NULL;
     cache_container_close_index(container);
     ret = cache_container_open_index(container, header->capacity_in_blocks*2);
-    if(ret != ERROR_SUCCESS)
+    if(ret == ERROR_SUCCESS && !(container->header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0)))
+        ret = GetLastError();
+    if(ret != ERROR_SUCCESS) {
+        container->header = header;
         return ret;
-    header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
-    if(!header)
-        return GetLastError();
+    }
 
-    UnmapViewOfFile(*file_view);
-    *file_view = header;
+    UnmapViewOfFile(header);
+    *file_view = container->header;
     return ERROR_SUCCESS;
 }
 
@@ -3809,7 +3819,9 @@ BOOL WINAPI GetUrlCacheConfigInfoW(LPINTERNET_CACHE_CONFIG_INFOW info, LPDWORD s
     info->dwCacheSize = container->file_size / 1024;
     lstrcpynW(info->CachePath, container->path, MAX_PATH);
 
+    WaitForSingleObject(container->mutex, INFINITE);
     cache_container_close_index(container);
+    ReleaseMutex(container->mutex);
 
     TRACE("CachePath %s\n", debugstr_w(info->CachePath));
 
@@ -1034,10 +1034,10 @@ static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding
     }
     else
     {
-        dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-        readerinput_grow(readerinput, dest_len);
+        /* a byte sequence never decodes to more WCHARs than it has bytes */
+        readerinput_grow(readerinput, len);
         ptr = (WCHAR*)dest->data;
-        MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
+        dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, len);
         ptr[dest_len] = 0;
         dest->written += dest_len*sizeof(WCHAR);
     }
@@ -1088,10 +1088,9 @@ static HRESULT reader_more(xmlreader *reader)
     }
     else
     {
-        dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-        readerinput_grow(readerinput, dest_len);
+        readerinput_grow(readerinput, len);
         ptr = (WCHAR*)(dest->data + dest->written);
-        MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
+        dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, len);
         ptr[dest_len] = 0;
         dest->written += dest_len*sizeof(WCHAR);
         /* get rid of processed data */
@@ -1152,10 +1151,15 @@ static void reader_skipn(xmlreader *reader, int n)
     encoded_buffer *buffer = &reader->input->buffer->utf16;
     const WCHAR *ptr;
 
-    while (*(ptr = reader_get_ptr(reader)) && n--)
+    while (n > 0 && *(ptr = reader_get_ptr(reader)))
     {
-        reader_update_position(reader, *ptr);
-        buffer->cur++;
+        /* consume everything that is already decoded before asking for more */
+        while (n && *ptr)
+        {
+            reader_update_position(reader, *ptr++);
+            buffer->cur++;
+            n--;
+        }
     }
 }
 
@@ -1169,10 +1173,13 @@ static int reader_skipspaces(xmlreader *reader)
 {
     const WCHAR *ptr = reader_get_ptr(reader);
     UINT start = reader_get_cur(reader);
+    int len;
 
     while (is_wchar_space(*ptr))
     {
-        reader_skipn(reader, 1);
+        for (len = 1; is_wchar_space(ptr[len]); len++)
+            ;
+        reader_skipn(reader, len);
         ptr = reader_get_ptr(reader);
     }
 
@@ -1462,10 +1469,18 @@ static HRESULT reader_parse_comment(xmlreader *reader)
                 else
                     return WC_E_COMMENT;
             }
+            reader_skipn(reader, 1);
+            ptr++;
         }
+        else
+        {
+            /* skip to the next '-' in one go */
+            UINT len = 1;
 
-        reader_skipn(reader, 1);
-        ptr++;
+            while (ptr[len] && ptr[len] != '-') len++;
+            reader_skipn(reader, len);
+            ptr += len;
+        }
     }
 
     return S_OK;
@@ -2201,9 +2216,16 @@ static HRESULT reader_parse_attvalue(xmlreader *reader, strval *value)
         }
         else
         {
-            /* replace all whitespace chars with ' ' */
-            if (is_wchar_space(*ptr)) *ptr = ' ';
-            reader_skipn(reader, 1);
+            UINT len = 0;
+
+            do
+            {
+                /* replace all whitespace chars with ' ' */
+                if (is_wchar_space(ptr[len])) ptr[len] = ' ';
+                len++;
+            } while (ptr[len] && ptr[len] != quote && ptr[len] != '<' && ptr[len] != '&');
+
+            reader_skipn(reader, len);
         }
         ptr = reader_get_ptr(reader);
     }
@@ -2474,13 +2496,25 @@ static HRESULT reader_parse_chardata(xmlreader *reader)
             return S_OK;
         }
 
-        /* this covers a case when text has leading whitespace chars */
-        if (!is_wchar_space(*ptr)) reader->nodetype = XmlNodeType_Text;
-
-        if (!reader_cmp(reader, L"&"))
+        if (*ptr == '&')
+        {
+            reader->nodetype = XmlNodeType_Text;
             reader_parse_reference(reader);
+        }
         else
-            reader_skipn(reader, 1);
+        {
+            /* skip a run of plain characters at once */
+            UINT len = 0;
+
+            do
+            {
+                /* this covers a case when text has leading whitespace chars */
+                if (!is_wchar_space(ptr[len])) reader->nodetype = XmlNodeType_Text;
+                len++;
+            } while (ptr[len] && ptr[len] != '<' && ptr[len] != '&' && ptr[len] != ']');
+
+            reader_skipn(reader, len);
+        }
 
         ptr = reader_get_ptr(reader);
     }
@@ -240,17 +240,91 @@ WCHAR *WCMD_parameter (WCHAR *s, int n, WCHAR **start, BOOL raw,
  *       NULL on error or EOF
  */
 
+/* Data read ahead from a batch or for /f input file. Reading line by line
+   would otherwise need a full ReadFile for every line. The cached data is
+   only used while the file's identity, size and write time are unchanged,
+   so edits to a running batch file are still picked up. */
+#define READ_CACHE_SIZE 65536
+
+static struct
+{
+  HANDLE h;
+  BY_HANDLE_FILE_INFORMATION info;
+  LONGLONG start;       /* file offset of data[0] */
+  DWORD len;
+  char *data;
+} read_cache;
+
+/* returns up to noChars bytes of a disk file at its current position, or NULL
+   if the file can't be cached */
+static const char *read_cached(HANDLE h, DWORD noChars, LARGE_INTEGER *filepos, DWORD *charsRead)
+{
+  BY_HANDLE_FILE_INFORMATION info;
+  LONGLONG size, end;
+
+  if (GetFileType(h) != FILE_TYPE_DISK || !GetFileInformationByHandle(h, &info))
+    return NULL;
+  if (!read_cache.data) read_cache.data = heap_xalloc(READ_CACHE_SIZE);
+
+  /* access times change as we read, so don't compare the whole structure */
+  if (read_cache.h != h || read_cache.info.dwVolumeSerialNumber != info.dwVolumeSerialNumber ||
+      read_cache.info.nFileIndexHigh != info.nFileIndexHigh || read_cache.info.nFileIndexLow != info.nFileIndexLow ||
+      read_cache.info.nFileSizeHigh != info.nFileSizeHigh || read_cache.info.nFileSizeLow != info.nFileSizeLow ||
+      CompareFileTime(&read_cache.info.ftLastWriteTime, &info.ftLastWriteTime)) {
+    read_cache.h = h;
+    read_cache.info = info;
+    read_cache.len = 0;
+  }
+
+  filepos->QuadPart = 0;
+  if (!SetFilePointerEx(h, *filepos, filepos, FILE_CURRENT)) return NULL;
+
+  size = ((LONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+  end = read_cache.start + read_cache.len;
+  if (filepos->QuadPart < read_cache.start || filepos->QuadPart > end ||
+      (filepos->QuadPart + noChars > end && end < size)) {
+    if (!ReadFile(h, read_cache.data, READ_CACHE_SIZE, &read_cache.len, NULL)) {
+      read_cache.len = 0;
+      return NULL;
+    }
+    read_cache.start = filepos->QuadPart;
+    end = read_cache.start + read_cache.len;
+  }
+
+  *charsRead = min(noChars, end - filepos->QuadPart);
+  return read_cache.data + (filepos->QuadPart - read_cache.start);
+}
+
 WCHAR *WCMD_fgets(WCHAR *buf, DWORD noChars, HANDLE h)
 {
   DWORD charsRead;
   BOOL status;
   DWORD i;
+  LARGE_INTEGER filepos;
+  const char *cached;
 
   /* We can't use the native f* functions because of the filename syntax differences
      between DOS and Unix. Also need to lose the LF (or CRLF) from the line. */
 
-  if (!ReadConsoleW(h, buf, noChars, &charsRead, NULL)) {
-      LARGE_INTEGER filepos;
+  if ((cached = read_cached(h, noChars, &filepos, &charsRead))) {
+      UINT cp = GetConsoleCP();
+      const char *p;
+
+      if (charsRead == 0) return NULL;
+
+      /* Find first EOL */
+      for (p = cached; p < (cached + charsRead); p = CharNextExA(cp, p, 0)) {
+          if (*p == '\n' || *p == '\r')
+              break;
+      }
+
+      /* Sets file pointer to the start of the next line, if any */
+      filepos.QuadPart += p - cached + 1 + (p < cached + charsRead && *p == '\r' ? 1 : 0);
+      SetFilePointerEx(h, filepos, NULL, FILE_BEGIN);
+
+      i = MultiByteToWideChar(cp, 0, cached, p - cached, buf, noChars);
+  }
+  else if (!ReadConsoleW(h, buf, noChars, &charsRead, NULL)) {
       char *bufA;
       UINT cp;
       const char *p;
@@ -3361,6 +3361,13 @@ echo abc > 012345678901234
 if exist 012345678901234 (echo Failure) else echo Success
 popd
 rmdir /s /q c:\abcdefghij
+echo ------------ Testing self-modifying batch file ------------
+echo echo appended>selfmod.txt
+echo @echo off>selfmod.cmd
+echo echo first>>selfmod.cmd
+echo type selfmod.txt^>^>selfmod.cmd>>selfmod.cmd
+call selfmod.cmd
+del selfmod.cmd selfmod.txt
 echo ------------ Testing combined CALLs/GOTOs ------------
 echo @echo off>foo.cmd
 echo goto :eof>>foot.cmd
@@ -18,6 +18,7 @@
  */
 
 #include <windows.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <shlwapi.h>
 
@@ -27,73 +28,83 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(findstr);
 
-static BOOL read_char_from_handle(HANDLE handle, char *char_out)
+#define BLOCK_SIZE 65536
+
+struct input
+{
+    HANDLE handle;
+    char *buffer;
+    DWORD size;
+    DWORD start;    /* start of the next line */
+    DWORD end;      /* end of the data read so far */
+    BOOL eof;
+};
+
+struct pattern
 {
-    static char buffer[4096];
-    static DWORD buffer_max = 0;
-    static DWORD buffer_pos = 0;
+    WCHAR *text;    /* upper-cased for /I */
+    int len;
+};
 
-    /* Read next content into buffer */
-    if (buffer_pos >= buffer_max)
-    {
-        BOOL success = ReadFile(handle, buffer, 4096, &buffer_max, NULL);
-        if (!success || !buffer_max)
-            return FALSE;
-        buffer_pos = 0;
-    }
+struct search
+{
+    struct pattern *patterns;
+    int count;
+    DWORD first_chars[256 / 32];    /* low bytes of the first character of literal patterns */
+    WCHAR *line;                    /* line converted to UTF-16 */
+    int line_size;
+    BOOL regex;
+    BOOL ignore_case;
+    BOOL match_begin;
+    BOOL match_end;
+    BOOL invert;
+    BOOL line_numbers;
+    BOOL names_only;
+    BOOL recursive;
+};
+
+static char output_buffer[BLOCK_SIZE];
+static DWORD output_len;
+
+static void flush_output(void)
+{
+    DWORD bytes_written;
 
-    *char_out = buffer[buffer_pos++];
-    return TRUE;
+    if (!output_len) return;
+    WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), output_buffer, output_len, &bytes_written, NULL);
+    if (bytes_written < output_len)
+        ERR("Failed to write output\n");
+    output_len = 0;
 }
 
-/* Read a line from a handle, returns NULL if the end is reached */
-static WCHAR* read_line_from_handle(HANDLE handle)
+static void write_output(const char *data, DWORD len)
 {
-    int line_max = 4096;
-    int length = 0;
-    WCHAR *line_converted;
-    int line_converted_length;
-    BOOL success;
-    char *line = heap_alloc(line_max);
+    DWORD bytes_written;
 
-    for (;;)
+    if (output_len + len > sizeof(output_buffer))
     {
-        char c;
-        success = read_char_from_handle(handle, &c);
-
-        /* Check for EOF */
-        if (!success)
+        flush_output();
+        if (len > sizeof(output_buffer))
         {
-            if (length == 0)
-                return NULL;
-            else
-                break;
+            WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data, len, &bytes_written, NULL);
+            if (bytes_written < len)
+                ERR("Failed to write output\n");
+            return;
         }
-
-        if (c == '\n')
-            break;
-
-        /* Make sure buffer is large enough */
-        if (length + 1 >= line_max)
-        {
-            line_max *= 2;
-            line = heap_realloc(line, line_max);
-        }
-
-        line[length++] = c;
     }
+    memcpy(output_buffer + output_len, data, len);
+    output_len += len;
+}
 
-    line[length] = 0;
-    if (length - 1 >= 0 && line[length - 1] == '\r') /* Strip \r of windows line endings */
-        line[length - 1] = 0;
-
-    line_converted_length = MultiByteToWideChar(CP_ACP, 0, line, -1, 0, 0);
-    line_converted = heap_alloc(line_converted_length * sizeof(WCHAR));
-    MultiByteToWideChar(CP_ACP, 0, line, -1, line_converted, line_converted_length);
-
-    heap_free(line);
+static void write_output_w(const WCHAR *str)
+{
+    char buffer[MAX_PATH * 2], *str_converted = buffer;
+    int len = WideCharToMultiByte(CP_ACP, 0, str, -1, NULL, 0, NULL, NULL);
 
-    return line_converted;
+    if (len > ARRAY_SIZE(buffer)) str_converted = heap_alloc(len);
+    WideCharToMultiByte(CP_ACP, 0, str, -1, str_converted, len, NULL, NULL);
+    write_output(str_converted, len - 1);
+    if (str_converted != buffer) heap_free(str_converted);
 }
 
 static void write_to_stdout(const WCHAR *str)
@@ -104,6 +115,8 @@ static void write_to_stdout(const WCHAR *str)
     UINT str_length = lstrlenW(str);
     int codepage = CP_ACP;
 
+    flush_output();
+
     str_converted_length = WideCharToMultiByte(codepage, 0, str, str_length, NULL, 0, NULL, NULL);
     str_converted = heap_alloc(str_converted_length);
     WideCharToMultiByte(codepage, 0, str, str_length, str_converted, str_converted_length, NULL, NULL);
@@ -115,26 +128,408 @@ static void write_to_stdout(const WCHAR *str)
     heap_free(str_converted);
 }
 
-static BOOL run_find_for_line(const WCHAR *line, const WCHAR *tofind)
+/* Return the next line without its line ending, or NULL if the end is reached.
+ * The input is read in large blocks and lines are returned in place. */
+static char *read_line(struct input *input, DWORD *length)
 {
-    WCHAR *found;
-    WCHAR lineending[] = {'\r', '\n', 0};
+    DWORD scanned = input->start, count;
+    char *line, *eol;
 
-    if (lstrlenW(line) == 0 || lstrlenW(tofind) == 0)
-        return FALSE;
+    for (;;)
+    {
+        if ((eol = memchr(input->buffer + scanned, '\n', input->end - scanned)))
+            break;
+        if (input->eof)
+        {
+            if (input->start == input->end)
+                return NULL;
+            eol = input->buffer + input->end;
+            break;
+        }
+
+        /* Move the partial line to the front and read the next block behind it */
+        if (input->start)
+        {
+            memmove(input->buffer, input->buffer + input->start, input->end - input->start);
+            input->end -= input->start;
+            input->start = 0;
+        }
+        scanned = input->end;
+        if (input->size - input->end < BLOCK_SIZE)
+        {
+            input->size = input->size ? input->size * 2 : 2 * BLOCK_SIZE;
+            input->buffer = heap_realloc(input->buffer, input->size);
+        }
+        count = 0;
+        if (!ReadFile(input->handle, input->buffer + input->end, BLOCK_SIZE, &count, NULL) || !count)
+            input->eof = TRUE;
+        input->end += count;
+    }
+
+    line = input->buffer + input->start;
+    *length = eol - line;
+    input->start = min(eol + 1 - input->buffer, input->end);
 
-    found = wcsstr(line, tofind);
+    if (*length && line[*length - 1] == '\r') /* Strip \r of windows line endings */
+        (*length)--;
+    return line;
+}
 
-    if (found)
+static inline BOOL is_word_char(WCHAR c)
+{
+    return iswalnum(c) || c == '_';
+}
+
+/* Return the length of the regular expression element at re */
+static int regex_atom_len(const WCHAR *re)
+{
+    const WCHAR *p = re;
+
+    if (*p == '\\' && p[1])
+        return 2;
+    if (*p == '[')
     {
-        write_to_stdout(line);
-        write_to_stdout(lineending);
+        while (*++p && *p != ']')
+            ;
+        return *p ? p - re + 1 : p - re;
+    }
+    return 1;
+}
+
+static BOOL regex_match_atom(const WCHAR *re, int len, WCHAR c)
+{
+    const WCHAR *p, *end;
+    BOOL negate, found = FALSE;
+
+    switch (*re)
+    {
+    case '.':
         return TRUE;
+    case '\\':
+        return len == 2 ? re[1] == c : c == '\\';
+    case '[':
+        p = re + 1;
+        end = re[len - 1] == ']' && len > 1 ? re + len - 1 : re + len;
+        if ((negate = (p < end && *p == '^')))
+            p++;
+        while (p < end && !found)
+        {
+            if (p + 2 < end && p[1] == '-')
+            {
+                found = c >= p[0] && c <= p[2];
+                p += 3;
+            }
+            else found = *p++ == c;
+        }
+        return found != negate;
+    default:
+        return *re == c;
     }
+}
+
+static BOOL regex_match_here(const WCHAR *re, const WCHAR *line, const WCHAR *pos, const WCHAR *end,
+                             BOOL match_end)
+{
+    const WCHAR *p;
+    int len;
+
+    for (;;)
+    {
+        if (!*re)
+            return !match_end || pos == end;
+        if (re[0] == '$' && !re[1])
+            return pos == end;
+        if (re[0] == '\\' && re[1] == '<')
+        {
+            if (pos == end || !is_word_char(*pos) || (pos > line && is_word_char(pos[-1])))
+                return FALSE;
+            re += 2;
+            continue;
+        }
+        if (re[0] == '\\' && re[1] == '>')
+        {
+            if (pos == line || !is_word_char(pos[-1]) || (pos < end && is_word_char(*pos)))
+                return FALSE;
+            re += 2;
+            continue;
+        }
+
+        len = regex_atom_len(re);
+        if (re[len] == '*')
+        {
+            /* Match as many as possible, then backtrack */
+            for (p = pos; p < end && regex_match_atom(re, len, *p); p++)
+                ;
+            for (;;)
+            {
+                if (regex_match_here(re + len + 1, line, p, end, match_end))
+                    return TRUE;
+                if (p == pos)
+                    return FALSE;
+                p--;
+            }
+        }
+
+        if (pos == end || !regex_match_atom(re, len, *pos))
+            return FALSE;
+        re += len;
+        pos++;
+    }
+}
+
+static BOOL regex_search(const struct search *search, const struct pattern *pattern, const WCHAR *line, int len)
+{
+    const WCHAR *re = pattern->text, *pos, *end = line + len;
+
+    if (*re == '^')
+        return regex_match_here(re + 1, line, line, end, search->match_end);
+    if (search->match_begin)
+        return regex_match_here(re, line, line, end, search->match_end);
+
+    for (pos = line; ; pos++)
+    {
+        if (regex_match_here(re, line, pos, end, search->match_end))
+            return TRUE;
+        if (pos == end)
+            return FALSE;
+    }
+}
+
+/* Scan the line once, only trying the patterns at positions where one of them can start */
+static BOOL literal_search(const struct search *search, const WCHAR *line, int len)
+{
+    const struct pattern *pattern;
+    int i, last = len - 1;
+
+    if (search->match_begin)
+        last = min(last, 0);
+
+    for (i = 0; i <= last; i++)
+    {
+        if (!(search->first_chars[(line[i] & 0xff) / 32] & (1u << (line[i] & 31))))
+            continue;
+        for (pattern = search->patterns; pattern < search->patterns + search->count; pattern++)
+        {
+            if (pattern->len > len - i || (search->match_end && pattern->len != len - i))
+                continue;
+            if (!memcmp(line + i, pattern->text, pattern->len * sizeof(WCHAR)))
+                return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static BOOL match_line(struct search *search, const char *line, DWORD length)
+{
+    int i, len = 0;
+
+    if (length)
+    {
+        if (search->line_size < (int)length + 1)
+        {
+            search->line_size = max(length + 1, search->line_size * 2);
+            search->line = heap_realloc(search->line, search->line_size * sizeof(WCHAR));
+        }
+        len = MultiByteToWideChar(CP_ACP, 0, line, length, search->line, length);
+        if (search->ignore_case)
+            CharUpperBuffW(search->line, len);
+    }
+    else if (!search->regex)
+        return FALSE;
+    else if (!search->line_size)
+    {
+        search->line_size = 1;
+        search->line = heap_alloc(sizeof(WCHAR));
+    }
+    search->line[len] = 0;
+
+    if (!search->regex)
+        return literal_search(search, search->line, len);
 
+    for (i = 0; i < search->count; i++)
+        if (regex_search(search, &search->patterns[i], search->line, len))
+            return TRUE;
     return FALSE;
 }
 
+/* Search an open handle, returns TRUE if any line was printed */
+static BOOL search_handle(struct search *search, HANDLE handle, const WCHAR *name)
+{
+    struct input input = {handle};
+    DWORD length, line_number = 0;
+    BOOL found = FALSE;
+    char *line;
+
+    while ((line = read_line(&input, &length)))
+    {
+        line_number++;
+        if (match_line(search, line, length) == search->invert)
+            continue;
+
+        found = TRUE;
+        if (search->names_only)
+        {
+            if (name)
+            {
+                write_output_w(name);
+                write_output("\r\n", 2);
+            }
+            break;
+        }
+        if (name)
+        {
+            write_output_w(name);
+            write_output(":", 1);
+        }
+        if (search->line_numbers)
+        {
+            char number[16];
+            write_output(number, sprintf(number, "%lu:", line_number));
+        }
+        write_output(line, length);
+        write_output("\r\n", 2);
+    }
+
+    heap_free(input.buffer);
+    return found;
+}
+
+static BOOL search_file(struct search *search, const WCHAR *path, BOOL show_name)
+{
+    HANDLE input;
+    BOOL found;
+
+    input = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (input == INVALID_HANDLE_VALUE)
+    {
+        WCHAR file_path_upper[MAX_PATH];
+        WCHAR buffer_message[64];
+        WCHAR message[300];
+
+        lstrcpynW(file_path_upper, path, ARRAY_SIZE(file_path_upper));
+        wcsupr(file_path_upper);
+
+        LoadStringW(GetModuleHandleW(NULL), IDS_FILE_NOT_FOUND, buffer_message, ARRAY_SIZE(buffer_message));
+
+        wsprintfW(message, buffer_message, file_path_upper);
+        write_to_stdout(message);
+        return FALSE;
+    }
+
+    found = search_handle(search, input, show_name || search->names_only ? path : NULL);
+    CloseHandle(input);
+    return found;
+}
+
+static WCHAR *build_path(const WCHAR *dir, const WCHAR *name, const WCHAR *suffix)
+{
+    WCHAR *path = heap_alloc((wcslen(dir) + wcslen(name) + wcslen(suffix) + 1) * sizeof(WCHAR));
+
+    wcscpy(path, dir);
+    wcscat(path, name);
+    wcscat(path, suffix);
+    return path;
+}
+
+/* Search the files matching mask in dir, and in its subdirectories for /S.
+ * dir is either empty or ends with a path separator. */
+static BOOL search_directory(struct search *search, const WCHAR *dir, const WCHAR *mask)
+{
+    WIN32_FIND_DATAW data;
+    BOOL found = FALSE;
+    WCHAR *path;
+    HANDLE find;
+
+    path = build_path(dir, mask, L"");
+    find = FindFirstFileW(path, &data);
+    heap_free(path);
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            path = build_path(dir, data.cFileName, L"");
+            if (search_file(search, path, TRUE))
+                found = TRUE;
+            heap_free(path);
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+
+    if (!search->recursive)
+        return found;
+
+    path = build_path(dir, L"*", L"");
+    find = FindFirstFileW(path, &data);
+    heap_free(path);
+    if (find == INVALID_HANDLE_VALUE)
+        return found;
+    do
+    {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+            !wcscmp(data.cFileName, L".") || !wcscmp(data.cFileName, L".."))
+            continue;
+        path = build_path(dir, data.cFileName, L"\\");
+        if (search_directory(search, path, mask))
+            found = TRUE;
+        heap_free(path);
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+    return found;
+}
+
+static BOOL search_path(struct search *search, const WCHAR *file_path, BOOL show_name)
+{
+    const WCHAR *mask;
+    WCHAR *dir;
+    BOOL found;
+
+    if (!search->recursive && !wcspbrk(file_path, L"*?"))
+        return search_file(search, file_path, show_name);
+
+    for (mask = file_path + wcslen(file_path); mask > file_path; mask--)
+        if (mask[-1] == '\\' || mask[-1] == '/' || mask[-1] == ':')
+            break;
+
+    dir = heap_alloc((mask - file_path + 1) * sizeof(WCHAR));
+    memcpy(dir, file_path, (mask - file_path) * sizeof(WCHAR));
+    dir[mask - file_path] = 0;
+    found = search_directory(search, dir, mask);
+    heap_free(dir);
+    return found;
+}
+
+static void add_pattern(struct search *search, const WCHAR *text, int len)
+{
+    struct pattern *pattern;
+
+    if (!len)
+        return;
+
+    search->patterns = heap_realloc(search->patterns, (search->count + 1) * sizeof(*search->patterns));
+    pattern = &search->patterns[search->count++];
+    pattern->text = heap_alloc((len + 1) * sizeof(WCHAR));
+    memcpy(pattern->text, text, len * sizeof(WCHAR));
+    pattern->text[len] = 0;
+    pattern->len = len;
+}
+
+/* Break up (if necessary) a search string like "foo bar" or "foo | bar" into "foo" and "bar" */
+static void add_patterns(struct search *search, const WCHAR *text)
+{
+    int len;
+
+    while (*text)
+    {
+        len = wcscspn(text, L" |");
+        add_pattern(search, text, len);
+        text += len;
+        if (*text)
+            text++;
+    }
+}
+
 static void output_resource_message(int id)
 {
     WCHAR buffer[64];
@@ -144,14 +539,18 @@ static void output_resource_message(int id)
 
 int __cdecl wmain(int argc, WCHAR *argv[])
 {
-    WCHAR *line;
-    WCHAR *pattern = NULL; WCHAR *tofind = NULL;
+    struct search search = {0};
+    WCHAR *pattern = NULL;
+    const WCHAR *opt;
     int i;
     int exitcode;
     int file_paths_len = 0;
     int file_paths_max = 0;
     WCHAR** file_paths = NULL;
     BOOL exact_match = FALSE;
+    BOOL force_literal = FALSE;
+    BOOL force_regex = FALSE;
+    BOOL show_names;
 
     TRACE("running find:");
     for (i = 0; i < argc; i++)
@@ -162,28 +561,71 @@ int __cdecl wmain(int argc, WCHAR *argv[])
 
     for (i = 1; i < argc; i++)
     {
-        if (argv[i][0] == '/')
+        if (argv[i][0] != '/')
+            continue;
+
+        for (opt = argv[i] + 1; *opt; opt++)
         {
-            switch(argv[i][1])
+            switch (towupper(*opt))
             {
             case '?':
                 output_resource_message(IDS_USAGE);
                 return 0;
+            case 'B':
+                search.match_begin = TRUE;
+                break;
             case 'C':
-            case 'c':
-                 if (argv[i][2] == ':')
-                 {
-                     pattern = argv[i] + 3;
-                     exact_match = TRUE;
-                 }
-                 break;
+                if (opt[1] == ':')
+                {
+                    add_pattern(&search, opt + 2, wcslen(opt + 2));
+                    exact_match = TRUE;
+                    opt += wcslen(opt) - 1;
+                }
+                break;
+            case 'E':
+                search.match_end = TRUE;
+                break;
+            case 'I':
+                search.ignore_case = TRUE;
+                break;
+            case 'L':
+                force_literal = TRUE;
+                break;
+            case 'M':
+                search.names_only = TRUE;
+                break;
+            case 'N':
+                search.line_numbers = TRUE;
+                break;
+            case 'R':
+                force_regex = TRUE;
+                break;
+            case 'S':
+                search.recursive = TRUE;
+                break;
+            case 'V':
+                search.invert = TRUE;
+                break;
+            case 'X':
+                search.match_begin = search.match_end = TRUE;
+                break;
             default:
-                ;
+                FIXME("Unsupported option %s\n", wine_dbgstr_w(opt));
+                opt += wcslen(opt) - 1;
+                break;
             }
         }
-        else if (pattern == NULL)
+    }
+
+    for (i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '/')
+            continue;
+
+        if (pattern == NULL && !exact_match)
         {
             pattern = argv[i];
+            add_patterns(&search, pattern);
         }
         else
         {
@@ -196,73 +638,58 @@ int __cdecl wmain(int argc, WCHAR *argv[])
         }
     }
 
-    if (pattern == NULL)
+    if (pattern == NULL && !exact_match)
     {
         output_resource_message(IDS_INVALID_PARAMETER);
         return 2;
     }
 
-    exitcode = 1;
-
-    if (file_paths_len > 0)
+    /* Like native, search strings are regular expressions unless /L is given, while /C: strings
+     * are literal unless /R is given. Strings without metacharacters use the literal search. */
+    if (force_regex)
+        search.regex = TRUE;
+    else if (!force_literal && !exact_match)
     {
-        for (i = 0; i < file_paths_len; i++)
-        {
-            HANDLE input;
-            WCHAR file_path_upper[MAX_PATH];
+        for (i = 0; i < search.count && !search.regex; i++)
+            if (wcspbrk(search.patterns[i].text, L".*^$[\\"))
+                search.regex = TRUE;
+    }
 
-            wcscpy(file_path_upper, file_paths[i]);
-            wcsupr(file_path_upper);
+    for (i = 0; i < search.count; i++)
+    {
+        struct pattern *p = &search.patterns[i];
 
-            input = CreateFileW(file_paths[i], GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (search.ignore_case)
+            CharUpperBuffW(p->text, p->len);
+        search.first_chars[(p->text[0] & 0xff) / 32] |= 1u << (p->text[0] & 31);
+    }
 
-            if (input == INVALID_HANDLE_VALUE)
-            {
-                WCHAR buffer_message[64];
-                WCHAR message[300];
+    exitcode = 1;
 
-                LoadStringW(GetModuleHandleW(NULL), IDS_FILE_NOT_FOUND, buffer_message, ARRAY_SIZE(buffer_message));
+    if (file_paths_len > 0)
+    {
+        show_names = file_paths_len > 1 || search.recursive;
+        for (i = 0; i < file_paths_len && !show_names; i++)
+            if (wcspbrk(file_paths[i], L"*?")) show_names = TRUE;
 
-                wsprintfW(message, buffer_message, file_path_upper);
-                write_to_stdout(message);
-                continue;
-            }
-            while ((line = read_line_from_handle(input)) != NULL)
-            {
-                tofind = _wcstok (pattern, exact_match ? L"" : L" |" ); /* break up (if necessary) search pattern like "foo bar" or "foo | bar" into "foo" and "bar" */
-                    while (tofind != NULL)
-                    {
-                        if (run_find_for_line(line, tofind))
-                        {
-                            exitcode = 0;
-                            break;
-                        }
-                        tofind = _wcstok (NULL, L" |");
-                     }
-            heap_free(line);
-            }
-            CloseHandle(input);
+        for (i = 0; i < file_paths_len; i++)
+        {
+            if (search_path(&search, file_paths[i], show_names))
+                exitcode = 0;
         }
     }
     else
     {
-        HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
-        while ((line = read_line_from_handle(input)) != NULL)
-        {
-            tofind = _wcstok (pattern, exact_match ? L"" : L" |" ); /* break up (if necessary) search pattern like "foo bar" or "foo | bar" into "foo" and "bar" */
-            while (tofind != NULL)
-            {
-                if (run_find_for_line(line, tofind))
-                {
-                    exitcode = 0;
-                    break;
-                }
-                tofind = _wcstok (NULL, L" |");
-             }
-        heap_free(line);
-        }
+        if (search_handle(&search, GetStdHandle(STD_INPUT_HANDLE), NULL))
+            exitcode = 0;
     }
 
+    flush_output();
+
+    for (i = 0; i < search.count; i++)
+        heap_free(search.patterns[i].text);
+    heap_free(search.patterns);
+    heap_free(search.line);
     heap_free(file_paths);
     return exitcode;
 }
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2022 Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <windows.h>
+#include <stdio.h>
+
+#include "wine/heap.h"
+#include "wine/test.h"
+
+static void read_all_from_handle(HANDLE handle, char **str, DWORD *len)
+{
+    char buffer[4096];
+    DWORD bytes_read;
+    DWORD length = 0;
+    char *ret = heap_alloc_zero(1);
+
+    for (;;)
+    {
+        if (!ReadFile(handle, buffer, sizeof(buffer), &bytes_read, NULL) || !bytes_read)
+            break;
+        ret = heap_realloc(ret, length + bytes_read + 1);
+        memcpy(ret + length, buffer, bytes_read);
+        length += bytes_read;
+    }
+    ret[length] = 0;
+
+    *str = ret;
+    *len = length;
+}
+
+#define run_findstr(commandline, input, out_expected, exitcode_expected) \
+        run_findstr_(commandline, input, out_expected, exitcode_expected, __FILE__, __LINE__)
+
+static void run_findstr_(const char *commandline, const char *input, const char *out_expected,
+                         DWORD exitcode_expected, const char *file, int line)
+{
+    HANDLE child_stdin_read, child_stdout_write, parent_stdin_write, parent_stdout_read;
+    STARTUPINFOA startup_info = {0};
+    SECURITY_ATTRIBUTES security_attributes;
+    PROCESS_INFORMATION process_info = {0};
+    char cmd[4096], *output;
+    DWORD exitcode, len;
+    BOOL ret;
+
+    security_attributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+    security_attributes.bInheritHandle = TRUE;
+    security_attributes.lpSecurityDescriptor = NULL;
+
+    CreatePipe(&parent_stdout_read, &child_stdout_write, &security_attributes, 0);
+    CreatePipe(&child_stdin_read, &parent_stdin_write, &security_attributes, 0);
+
+    SetHandleInformation(parent_stdout_read, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(parent_stdin_write, HANDLE_FLAG_INHERIT, 0);
+
+    startup_info.cb = sizeof(startup_info);
+    startup_info.hStdInput = child_stdin_read;
+    startup_info.hStdOutput = child_stdout_write;
+    startup_info.hStdError = NULL;
+    startup_info.dwFlags |= STARTF_USESTDHANDLES;
+
+    sprintf(cmd, "findstr.exe %s", commandline);
+
+    ret = CreateProcessA(NULL, cmd, NULL, NULL, TRUE, 0, NULL, NULL, &startup_info, &process_info);
+    ok_(file, line)(ret, "CreateProcess failed: %lu\n", GetLastError());
+    CloseHandle(child_stdin_read);
+    CloseHandle(child_stdout_write);
+
+    WriteFile(parent_stdin_write, input, strlen(input), &len, NULL);
+    CloseHandle(parent_stdin_write);
+
+    read_all_from_handle(parent_stdout_read, &output, &len);
+    CloseHandle(parent_stdout_read);
+
+    WaitForSingleObject(process_info.hProcess, INFINITE);
+    GetExitCodeProcess(process_info.hProcess, &exitcode);
+    CloseHandle(process_info.hProcess);
+    CloseHandle(process_info.hThread);
+
+    ok_(file, line)(len == strlen(out_expected) && !memcmp(output, out_expected, len),
+                    "%s: expected %s, got %s\n", debugstr_a(commandline), debugstr_a(out_expected), debugstr_a(output));
+    ok_(file, line)(exitcode == exitcode_expected, "%s: expected exit code %lu, got %lu\n",
+                    debugstr_a(commandline), exitcode_expected, exitcode);
+    heap_free(output);
+}
+
+static void create_file(const char *name, const char *data)
+{
+    HANDLE file;
+    DWORD written;
+
+    file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create %s: %lu\n", name, GetLastError());
+    WriteFile(file, data, strlen(data), &written, NULL);
+    CloseHandle(file);
+}
+
+static void test_literal(void)
+{
+    run_findstr("abc", "", "", 1);
+    run_findstr("abc", "abc", "abc\r\n", 0);
+    run_findstr("abc", "xyz\r\nxabcx\r\nab c\r\n", "xabcx\r\n", 0);
+    run_findstr("/L h.llo", "hello\r\nh.llo\r\n", "h.llo\r\n", 0);
+    run_findstr("/C:h.llo", "hello\r\nh.llo\r\n", "h.llo\r\n", 0);
+    run_findstr("/B ab", "ab\r\ncab\r\n", "ab\r\n", 0);
+    run_findstr("/E ab", "abc\r\ncab\r\n", "cab\r\n", 0);
+    run_findstr("/X ab", "ab\r\nabc\r\ncab\r\n", "ab\r\n", 0);
+    run_findstr("/I ABC", "aBc\r\nxyz\r\n", "aBc\r\n", 0);
+    run_findstr("/N b", "a\r\nb\r\nc\r\nb\n", "2:b\r\n4:b\r\n", 0);
+}
+
+static void test_regex(void)
+{
+    /* search strings are regular expressions by default */
+    run_findstr("h.llo", "hello\r\nhllo\r\nhxllo\r\n", "hello\r\nhxllo\r\n", 0);
+    run_findstr("/R h.llo", "hello\r\nhllo\r\nhxllo\r\n", "hello\r\nhxllo\r\n", 0);
+    run_findstr("/R \"^ab*c$\"", "ac\r\nabbbc\r\nxabc\r\nabcx\r\n", "ac\r\nabbbc\r\n", 0);
+    run_findstr("/R \"a.*z\"", "az\r\nabcz\r\nza\r\n", "az\r\nabcz\r\n", 0);
+    run_findstr("/R \"a\\.b\"", "a.b\r\naxb\r\n", "a.b\r\n", 0);
+
+    /* character classes */
+    run_findstr("/R \"[0-9][a-c]\"", "1a\r\n2d\r\nz9b\r\n", "1a\r\nz9b\r\n", 0);
+    run_findstr("/R \"x[^0-9]\"", "x1\r\nxa\r\n", "xa\r\n", 0);
+    run_findstr("/R \"^[abc]*$\"", "abcabc\r\nabcd\r\n", "abcabc\r\n", 0);
+
+    /* word boundaries */
+    run_findstr("/R \"\\<cat\\>\"", "cat\r\nconcat\r\ncats\r\nthe cat sat\r\n", "cat\r\nthe cat sat\r\n", 0);
+    run_findstr("/R \"\\<cat\"", "concat\r\ncats\r\n", "cats\r\n", 0);
+    run_findstr("/R \"cat\\>\"", "concat\r\ncats\r\n", "concat\r\n", 0);
+
+    /* case insensitive regular expressions */
+    run_findstr("/I /R \"^he.lo\"", "hello\r\nHeLLo\r\nxhello\r\n", "hello\r\nHeLLo\r\n", 0);
+    run_findstr("/I /R \"[a-c]z\"", "BZ\r\ndz\r\n", "BZ\r\n", 0);
+    run_findstr("/R /C:\"x.z\"", "xyz\r\nabc\r\n", "xyz\r\n", 0);
+}
+
+static void test_multiple_patterns(void)
+{
+    run_findstr("\"foo qux\"", "foo bar\r\nfoo\r\nbar baz\r\nqux\r\n", "foo bar\r\nfoo\r\nqux\r\n", 0);
+    run_findstr("/C:\"foo bar\" /C:baz", "foo bar\r\nfoo\r\nbar baz\r\nqux\r\n", "foo bar\r\nbar baz\r\n", 0);
+    run_findstr("/C:\"o b\" /C:qux /C:zzz", "foo bar\r\nfoo\r\nqux\r\n", "foo bar\r\nqux\r\n", 0);
+    run_findstr("/I /C:FOO /C:Baz", "foo\r\nbaz\r\nbar\r\n", "foo\r\nbaz\r\n", 0);
+}
+
+static void test_invert(void)
+{
+    run_findstr("/V a", "a\r\n\r\nb\r\n", "\r\nb\r\n", 0);
+    run_findstr("/V /R .", "a\r\n\r\nb\r\n", "\r\n", 0);
+    run_findstr("/V /N a", "a\r\n\r\nb\r\n", "2:\r\n3:b\r\n", 0);
+    run_findstr("/V a", "a\r\naa\r\n", "", 1);
+}
+
+static void test_files(void)
+{
+    char temp_dir[MAX_PATH], test_dir[MAX_PATH], old_dir[MAX_PATH];
+
+    GetCurrentDirectoryA(ARRAY_SIZE(old_dir), old_dir);
+    GetTempPathA(ARRAY_SIZE(temp_dir), temp_dir);
+    sprintf(test_dir, "%sfindstr_test", temp_dir);
+    CreateDirectoryA(test_dir, NULL);
+    SetCurrentDirectoryA(test_dir);
+    CreateDirectoryA("sub", NULL);
+
+    create_file("a.txt", "apple\r\nbanana\r\n");
+    create_file("b.log", "apple\r\n");
+    create_file("sub\\c.txt", "cherry apple\r\n");
+    create_file("sub\\d.txt", "none\r\n");
+
+    run_findstr("banana a.txt", "", "banana\r\n", 0);
+    run_findstr("banana a.txt b.log", "", "a.txt:banana\r\n", 0);
+    run_findstr("apple *.txt", "", "a.txt:apple\r\n", 0);
+    run_findstr("apple *.lo?", "", "b.log:apple\r\n", 0);
+    run_findstr("/S apple *.txt", "", "a.txt:apple\r\nsub\\c.txt:cherry apple\r\n", 0);
+    run_findstr("/S /N cherry *.txt", "", "sub\\c.txt:1:cherry apple\r\n", 0);
+    run_findstr("/S /M apple *.txt", "", "a.txt\r\nsub\\c.txt\r\n", 0);
+    run_findstr("/S apple sub\\*.txt", "", "sub\\c.txt:cherry apple\r\n", 0);
+    run_findstr("/S kiwi *.txt", "", "", 1);
+
+    DeleteFileA("sub\\c.txt");
+    DeleteFileA("sub\\d.txt");
+    DeleteFileA("a.txt");
+    DeleteFileA("b.log");
+    RemoveDirectoryA("sub");
+    SetCurrentDirectoryA(old_dir);
+    RemoveDirectoryA(test_dir);
+}
+
+START_TEST(findstr)
+{
+    test_literal();
+    test_regex();
+    test_multiple_patterns();
+    test_invert();
+    test_files();
+}
@@ -58,6 +58,9 @@ struct file
     char              *name;          /* full file name relative to cwd */
     void              *args;          /* custom arguments for makefile rule */
     unsigned int       flags;         /* flags (see below) */
+    unsigned int       parse_flags;   /* flags set by the parser, saved in the cache */
+    time_t             mtime;         /* modification time when parsed */
+    off_t              size;          /* file size when parsed */
     unsigned int       deps_count;    /* files in use */
     unsigned int       deps_size;     /* total allocated size */
     struct dependency *deps;          /* all header dependencies */
@@ -98,6 +101,7 @@ struct incl_file
 #define FLAG_C_IMPLIB       0x020000  /* file is part of an import library */
 #define FLAG_C_UNIX         0x040000  /* file is part of a Unix library */
 #define FLAG_SFD_FONTS      0x080000  /* sfd file generated bitmap fonts */
+#define FLAG_NOT_FOUND      0x100000  /* file doesn't exist, cached to avoid repeated lookups */
 
 static const struct
 {
@@ -115,9 +119,21 @@ static const struct
     { FLAG_IDL_HEADER,     ".h" }
 };
 
-#define HASH_SIZE 997
+#define HASH_SIZE 65521
 
 static struct list files[HASH_SIZE];
+static struct list cached_files[HASH_SIZE];
+
+/* statistics for the timing report */
+static struct
+{
+    unsigned int parsed;      /* files read and parsed */
+    unsigned int cached;      /* files loaded from the dependency cache */
+    unsigned int missing;     /* lookups of nonexistent files */
+    clock_t      start;
+    clock_t      parse;       /* time spent loading sources */
+    clock_t      output;      /* time spent writing makefiles */
+} stats;
 
 enum install_rules { INSTALL_LIB, INSTALL_DEV, NB_INSTALL_RULES };
 
@@ -230,12 +246,16 @@ static struct makefile *top_makefile;
 static struct makefile **submakes;
 
 static const char separator[] = "### Dependencies";
+static const char *cache_signature;
 static const char *output_makefile_name = "Makefile";
 static const char *input_file_name;
 static const char *output_file_name;
 static const char *temp_file_name;
+static const char *cache_file_name;
+static time_t start_time;
 static int relative_dir_mode;
 static int silent_rules;
+static int show_timings;
 static int input_line;
 static int output_column;
 static FILE *output_file;
@@ -245,6 +265,8 @@ static const char Usage[] =
     "Options:\n"
     "   -R from to  Compute the relative path between two directories\n"
     "   -S          Generate Automake-style silent rules\n"
+    "   -T          Print a timing report on stderr\n"
+    "   -Cxxx       Cache parsed file dependencies in file 'xxx'\n"
     "   -fxxx       Store output in file 'xxx' (default: Makefile)\n";
 
 
@@ -1150,22 +1172,59 @@ static const struct
     { ".sfd", parse_sfd_file }
 };
 
+/*******************************************************************
+ *         get_cached_file
+ *
+ * Retrieve a file from the dependency cache, if it hasn't been modified.
+ */
+static struct file *get_cached_file( const char *name, unsigned int hash, const struct stat *st )
+{
+    struct file *file;
+
+    LIST_FOR_EACH_ENTRY( file, &cached_files[hash], struct file, entry )
+    {
+        if (strcmp( name, file->name )) continue;
+        list_remove( &file->entry );
+        if (file->mtime != st->st_mtime || file->size != st->st_size) return NULL;
+        return file;
+    }
+    return NULL;
+}
+
+
 /*******************************************************************
  *         load_file
  */
 static struct file *load_file( const char *name )
 {
     struct file *file;
+    struct stat st;
     FILE *f;
+    int cacheable;
     unsigned int i, hash = hash_filename( name );
 
     LIST_FOR_EACH_ENTRY( file, &files[hash], struct file, entry )
-        if (!strcmp( name, file->name )) return file;
+        if (!strcmp( name, file->name )) return (file->flags & FLAG_NOT_FOUND) ? NULL : file;
 
-    if (!(f = fopen( name, "r" ))) return NULL;
+    if ((cacheable = cache_file_name && !stat( name, &st )) &&
+        (file = get_cached_file( name, hash, &st )))
+    {
+        list_add_tail( &files[hash], &file->entry );
+        stats.cached++;
+        return file;
+    }
 
     file = add_file( name );
     list_add_tail( &files[hash], &file->entry );
+
+    if ((cache_file_name && !cacheable) || !(f = fopen( name, "r" )))
+    {
+        /* remember it, the same name gets looked up in every makefile */
+        file->flags = FLAG_NOT_FOUND;
+        stats.missing++;
+        return NULL;
+    }
+
     input_file_name = file->name;
     input_line = 0;
 
@@ -1179,6 +1238,14 @@ static struct file *load_file( const char *name )
     fclose( f );
     input_file_name = NULL;
 
+    file->parse_flags = file->flags;
+    if (cacheable)
+    {
+        file->mtime = st.st_mtime;
+        file->size = st.st_size;
+    }
+    else file->mtime = start_time;  /* don't save it in the cache */
+    stats.parsed++;
     return file;
 }
 
@@ -3718,6 +3785,7 @@ static void output_sources( struct makefile *make )
             strarray_add( &make->all_targets, make->extra_targets.str[i] );
 
     if (!make->src_dir) strarray_add( &make->distclean_files, ".gitignore" );
+    if (!make->obj_dir && cache_file_name) strarray_add( &make->distclean_files, cache_file_name );
     strarray_add( &make->distclean_files, "Makefile" );
     if (make->testdll) strarray_add( &make->distclean_files, "testlist.c" );
 
@@ -3852,6 +3920,132 @@ static void rename_temp_file_if_changed( const char *dest )
 }
 
 
+/*******************************************************************
+ *         load_cache_file
+ *
+ * Load the dependencies saved by a previous run. Each file starts with
+ * a line "F <mtime> <size> <flags> <name>", followed by its dependencies
+ * "D <line> <type> <name>" and its arguments "A <arg>".
+ */
+static void load_cache_file(void)
+{
+    struct file *file = NULL;
+    struct strarray *array;
+    char *buffer, *p;
+    time_t mtime;
+    off_t size;
+    unsigned int i, flags;
+    int line, type;
+    FILE *f;
+
+    if (!(f = fopen( cache_file_name, "r" ))) return;
+
+    input_line = 0;
+    if (!(buffer = get_line( f )) || strcmp( buffer, cache_signature )) goto done;
+
+    while ((buffer = get_line( f )))
+    {
+        if (!buffer[0] || buffer[1] != ' ') goto error;
+        p = buffer + 2;
+        switch (buffer[0])
+        {
+        case 'F':
+            mtime = strtoll( p, &p, 10 );
+            size = strtoll( p, &p, 10 );
+            flags = strtoul( p, &p, 16 );
+            if (*p++ != ' ' || !*p) goto error;
+            file = add_file( p );
+            file->mtime = mtime;
+            file->size = size;
+            file->flags = file->parse_flags = flags;
+            list_add_tail( &cached_files[hash_filename( p )], &file->entry );
+            break;
+        case 'D':
+            if (!file) goto error;
+            line = strtol( p, &p, 10 );
+            type = strtol( p, &p, 10 );
+            if (*p++ != ' ' || !*p) goto error;
+            add_dependency( file, p, type );
+            file->deps[file->deps_count - 1].line = line;
+            break;
+        case 'A':
+            if (!file) goto error;
+            if (file->flags & FLAG_SFD_FONTS)
+            {
+                if (!(array = file->args))
+                {
+                    file->args = array = xmalloc( sizeof(*array) );
+                    *array = empty_strarray;
+                }
+                strarray_add( array, xstrdup( p ));
+            }
+            else file->args = xstrdup( p );
+            break;
+        default:
+            goto error;
+        }
+    }
+    goto done;
+
+error:
+    fprintf( stderr, "%s:%u: malformed dependency cache, ignoring it\n", cache_file_name, input_line );
+    for (i = 0; i < HASH_SIZE; i++) list_init( &cached_files[i] );
+done:
+    fclose( f );
+    input_line = 0;
+}
+
+
+/*******************************************************************
+ *         save_cache_file
+ */
+static void save_cache_file(void)
+{
+    struct file *file;
+    struct strarray *array;
+    unsigned int i, j;
+    FILE *f = create_temp_file( cache_file_name );
+
+    fprintf( f, "%s\n", cache_signature );
+    for (i = 0; i < HASH_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY( file, &files[i], struct file, entry )
+        {
+            if (file->flags & FLAG_NOT_FOUND) continue;
+            /* a file modified while we were running may change again without a new timestamp */
+            if (file->mtime >= start_time) continue;
+
+            fprintf( f, "F %lld %lld %x %s\n", (long long)file->mtime, (long long)file->size,
+                     file->parse_flags, file->name );
+            for (j = 0; j < file->deps_count; j++)
+                fprintf( f, "D %d %d %s\n", file->deps[j].line, file->deps[j].type, file->deps[j].name );
+            if (!file->args) continue;
+            if (file->parse_flags & FLAG_SFD_FONTS)
+            {
+                array = file->args;
+                for (j = 0; j < array->count; j++) fprintf( f, "A %s\n", array->str[j] );
+            }
+            else fprintf( f, "A %s\n", (const char *)file->args );
+        }
+    }
+    if (fclose( f )) fatal_perror( "write" );
+    rename_temp_file_if_changed( cache_file_name );
+}
+
+
+/*******************************************************************
+ *         output_timings
+ */
+static void output_timings(void)
+{
+    fprintf( stderr, "makedep: %u files parsed, %u loaded from cache, %u lookups of missing files\n",
+             stats.parsed, stats.cached, stats.missing );
+    fprintf( stderr, "makedep: %.2fs loading sources, %.2fs writing makefiles\n",
+             (double)(stats.parse - stats.start) / CLOCKS_PER_SEC,
+             (double)(stats.output - stats.parse) / CLOCKS_PER_SEC );
+}
+
+
 /*******************************************************************
  *         output_linguas
  */
@@ -4233,6 +4427,12 @@ static int parse_option( const char *opt )
     case 'S':
         silent_rules = 1;
         break;
+    case 'T':
+        show_timings = 1;
+        break;
+    case 'C':
+        if (opt[2]) cache_file_name = opt + 2;
+        break;
     default:
         fprintf( stderr, "Unknown option '%s'\n%s", opt, Usage );
         exit(1);
@@ -4286,6 +4486,23 @@ int main( int argc, char *argv[] )
 #endif
 
     for (i = 0; i < HASH_SIZE; i++) list_init( &files[i] );
+    for (i = 0; i < HASH_SIZE; i++) list_init( &cached_files[i] );
+
+    start_time = time( NULL );
+    stats.start = clock();
+    if (cache_file_name)
+    {
+        struct stat st;
+
+        /* entries are only valid for the makedep binary that created them */
+        if (!stat( argv[0], &st ))
+        {
+            cache_signature = strmake( "# makedep dependency cache, version 1, %lld %lld",
+                                       (long long)st.st_mtime, (long long)st.st_size );
+            load_cache_file();
+        }
+        else cache_file_name = NULL;
+    }
 
     top_makefile = parse_makefile( NULL );
 
@@ -4348,9 +4565,13 @@ int main( int argc, char *argv[] )
 
     load_sources( top_makefile );
     for (i = 0; i < subdirs.count; i++) load_sources( submakes[i] );
+    stats.parse = clock();
 
     output_dependencies( top_makefile );
     for (i = 0; i < subdirs.count; i++) output_dependencies( submakes[i] );
+    stats.output = clock();
 
+    if (cache_file_name) save_cache_file();
+    if (show_timings) output_timings();
     return 0;
 }